@@ -0,0 +1,76 @@
+#include "serializer.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+static const std::string BenchFile = "bench.dat";
+static const u32 DoctorCount = 2000;
+static const u32 PatientCount = 200000;
+static const u32 Rounds = 3;
+
+static double elapsed(const std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void generate(const u32 appointmentCount) {
+    std::mt19937 rng (1);
+    std::vector<User> doctors, patients;
+    std::vector<std::shared_ptr<Appointment>> appointments;
+
+    for (u32 i = 0; i < DoctorCount; ++i) doctors.emplace_back(L"Doctor" + std::to_wstring(i), "Pa$$word1", static_cast<Type>(i % SpecializationCount));
+    for (u32 i = 0; i < PatientCount; ++i) patients.emplace_back(L"Patient" + std::to_wstring(i), "Pa$$word1");
+
+    appointments.reserve(appointmentCount);
+
+    for (u32 i = 0; i < appointmentCount; ++i)
+        appointments.push_back(std::make_shared<Appointment>(Date(rng() % 28 + 1, rng() % 12 + 1, 2024 + rng() % 3),
+                                                             rng() % DoctorCount, rng() % PatientCount, 8 * 60 + rng() % 40 * 15, 15));
+
+    Serializer(BenchFile).SaveData(doctors, patients, appointments, {});
+}
+
+static void measure() {
+    double load = 0, save = 0;
+
+    for (u32 round = 0; round < Rounds; ++round) {
+        std::vector<User> doctors, patients;
+        std::vector<std::shared_ptr<Appointment>> appointments;
+        std::vector<std::shared_ptr<Recurrence>> recurrences;
+        DoctorIndex doctorIndex;
+
+        auto start = std::chrono::steady_clock::now();
+        Serializer(BenchFile).LoadData(doctors, patients, appointments, recurrences, doctorIndex);
+        const double loaded = elapsed(start);
+
+        start = std::chrono::steady_clock::now();
+        Serializer(BenchFile + ".out").SaveData(doctors, patients, appointments, recurrences);
+        const double saved = elapsed(start);
+
+        load = round ? std::min(load, loaded) : loaded;
+        save = round ? std::min(save, saved) : saved;
+    }
+
+    std::wcout << ThreadPool::Shared().Size() << L"\t" << load << L"\t" << save << std::endl;
+}
+
+i32 main(i32 argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--measure") {
+        measure();
+        return 0;
+    }
+
+    const u32 appointmentCount = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    const u32 maxThreads = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    generate(appointmentCount);
+    std::wcout << appointmentCount << L" appointments, best of " << Rounds << L" rounds\nthreads\tload s\tsave s" << std::endl;
+
+    // The shared pool is sized once per process, so every thread count runs in its own child
+    for (u32 threads = 1; threads <= maxThreads; ++threads)
+        if (std::system(("CLINIC_THREADS=" + std::to_string(threads) + ' ' + argv[0] + " --measure").c_str()) != 0) return 1;
+
+    fs::remove(BenchFile);
+    fs::remove(BenchFile + ".out");
+    return 0;
+}
\ No newline at end of file
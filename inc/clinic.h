@@ -1,5 +1,11 @@
 #pragma once
-#include "serializer.h"
+#include "journal.h"
+#include <map>
+
+struct OpenSlots {
+    std::wstring doctor;
+    std::vector<u16> starts;
+};
 
 class Clinic {
     const std::vector<User> DefaultDoctors {
@@ -28,8 +34,15 @@ class Clinic {
 
     static const u32 CurrentYear = 2025;
 
-    static const u32 MinimumUsernameLength = 5;
-    static const u32 MaximumUsernameLength = 20;
+    static const u16 OpeningTime = 8 * 60;
+    static const u16 ClosingTime = 18 * 60;
+    static const u16 SlotStep = 15;
+    static const u16 MaximumDuration = 4 * 60;
+
+    static const u32 MaximumInterval = 12;
+    static const u32 MaximumVisits = 104;
+    static const u16 OccurrencePage = 8;
+    static const u32 MaximumUrgency = 5;
 
     static const u32 MinimumPasswordLength = 7;
     static const u32 MaximumPasswordLength = 50;
@@ -38,27 +51,55 @@ class Clinic {
     const std::wstring SelectedColor = getCol({ 245, 212, 66 });
     const std::wstring UnselectedColor = getCol({ 112, 109, 96 });
 
-    const Serializer serializer;
+    Serializer serializer;
+    Journal journal;
     std::shared_ptr<User> CurrentUser;
     std::vector<std::shared_ptr<Appointment>> CurrentAppointments;
+    std::vector<u32> CurrentPositions;
     u32 CurrentIdx;
 
     std::vector<User> doctors, patients;
     std::vector<std::shared_ptr<Appointment>> appointments;
+    std::vector<std::shared_ptr<Recurrence>> recurrences;
+    DoctorIndex doctorIndex;
+    Waitlist waitlist;
+    std::map<u32, std::vector<std::shared_ptr<Appointment>>> archive;
+    bool fullyLoaded = true;
 
-	void saveData() const;
+	void saveData();
+	void record(const Event&);
+	void loadData();
 	void initializeData();
+	void ensureLoaded();
 	void fetchAppointments(const bool);
+	void recoverArchives();
+	void loadArchive();
+	void showHistory(const bool);
 	void modifyDate(Date&) const;
-	std::pair<std::shared_ptr<User>, u32> pickUser(const bool, const Date& date = Date::Default) const;
+	void modifyTime(u16&, u16&) const;
+	bool pickSlot(const u32, const Date&, const u16, u16&, const Appointment*) const;
+	std::pair<std::shared_ptr<User>, u32> pickUser(const bool, const Date& date = Date::Default, const u16 start = 0, const u16 duration = 0) const;
 	void createAppointment();
 	void deleteAppointment(const u8);
+	void offerSlot(const Appointment&);
+	void joinWaitlist();
+	void waitlistMenu();
+	void createRecurrence();
+	void moveOccurrence(Recurrence&, const u16);
+	void occurrenceMenu(Recurrence&);
+	void recurrenceMenu(const bool);
 	void mainServiceMenu(const bool);
 	std::pair<std::shared_ptr<User>, u32> isValidName(const std::wstring&) const;
 	bool showPasswordError(const bool, const std::wstring&) const;
-	void execPatientMenu(const bool);
 
 public:
     Clinic(const std::string&);
-    void MainMenu();
+    bool Enter(const bool, const std::wstring&);
+    bool HasUser(const std::wstring&) const;
+    std::vector<std::wstring> UserNames() const;
+    std::vector<OpenSlots> FreeSlots(const Type, const Date&, const u16);
+    u32 Compact();
+    void Snapshot(const std::string&);
+    void PrintReport(const Date&, const Date&, const bool);
+    bool Audit(const std::wstring&, const Date&, const u64);
 };
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+#include "utils.h"
+#include <string>
+
+static const u64 MaximumExpansion = 0x100;
+
+std::string Compress(const std::string&);
+bool Decompress(const std::string&, const u64, std::string&);
+u32 Checksum(const std::string&);
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "utils.h"
 #include <string>
 #include <memory>
+#include <vector>
+#include <map>
 
 struct Date {
     u8 day, month;
@@ -10,11 +12,18 @@ struct Date {
     Date(const u8, const u8, const u32);
     Date();
     std::wstring str() const;
+    u32 key() const;
+    bool valid() const;
+    i32 days() const;
+    u8 weekday() const;
 
     Date& operator=(const Date&);
     bool operator==(const Date&);
 
     static const Date Default;
+    static Date fromDays(const i32);
+    static Date today();
+    static bool parse(const std::string&, Date&);
 };
 
 struct User {
@@ -23,6 +32,7 @@ struct User {
     Type type;
 
     User(const std::wstring&, const std::string&, const Type type = Type::Patient);
+    User();
     User(const User& other) = default;
 };
 
@@ -30,7 +40,37 @@ struct User {
 struct Appointment {
     Date date;
     u32 patientIdx, doctorIdx;
+    u16 start, duration;
 
-    Appointment(const Date, const u32, const u32);
+    Appointment(const Date, const u32, const u32, const u16 start = DefaultStart, const u16 duration = DefaultDuration);
     Appointment();
+
+    i64 begin() const;
+    i64 end() const;
+    std::wstring timeStr() const;
+
+    static const u16 MinutesPerDay = 24 * 60;
+    static const u16 DefaultStart = 9 * 60;
+    static const u16 DefaultDuration = 30;
+    static std::wstring timeStr(const u16);
 };
+
+
+enum class Frequency : u8 { Weekly, Monthly };
+
+struct Recurrence {
+    Appointment first;
+    Frequency frequency;
+    u8 interval;
+    u16 count;
+    std::map<u16, std::shared_ptr<Appointment>> exceptions;
+
+    Recurrence(const Appointment&, const Frequency, const u8, const u16);
+    Recurrence();
+
+    Appointment Occurrence(const u16) const;
+    u16 LowerIndex(const i32) const;
+    bool OccursOn(const i32, Appointment&) const;
+    std::vector<Appointment> Expand(const i32, const i32) const;
+    std::wstring ruleStr() const;
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include "data.h"
+#include <vector>
+#include <array>
+#include <map>
+
+class DoctorIndex {
+	using Calendar = std::multimap<i64, std::pair<i64, const Appointment*>>;
+
+	std::array<std::vector<u32>, SpecializationCount> partitions;
+	std::vector<std::pair<Type, u32>> positions;
+	std::vector<Calendar> calendars;
+	std::vector<u16> longest;
+	std::vector<std::vector<const Recurrence*>> series;
+
+	static bool isSpecialization(const Type);
+	void ensureDoctor(const u32);
+	bool overlaps(const u32, const i64, const i64, const Appointment*) const;
+
+public:
+	void Build(const std::vector<User>&, const std::vector<std::shared_ptr<Appointment>>&, const std::vector<std::shared_ptr<Recurrence>>&);
+	void AddDoctor(const u32, const Type);
+	void UpdateDoctor(const u32, const Type);
+	void Book(const Appointment&);
+	void Release(const Appointment&);
+	void AddSeries(const Recurrence&);
+	void RemoveSeries(const Recurrence&);
+
+	const std::vector<u32>& Doctors(const Type) const;
+	bool IsFree(const u32, const Date&, const u16, const u16, const Appointment* ignore = nullptr) const;
+	std::vector<u32> FreeDoctors(const Type, const Date&, const u16, const u16) const;
+	std::vector<u32> FreeDoctors(const Date&, const u16, const u16) const;
+	std::vector<u16> FreeSlots(const u32, const Date&, const u16, const u16, const u16, const u16, const Appointment* ignore = nullptr) const;
+};
\ No newline at end of file
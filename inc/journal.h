@@ -0,0 +1,76 @@
+#pragma once
+#include "serializer.h"
+#include <vector>
+#include <unordered_map>
+
+enum class EventType : u8 {
+    AppointmentCreated, AppointmentDeleted, AppointmentMoved,
+    DoctorReplaced, PatientReplaced, PatientRegistered,
+    RecurrenceCreated, RecurrenceRemoved, OccurrenceCancelled, OccurrenceMoved,
+    Compacted
+};
+
+struct Event {
+    EventType type;
+    u64 time = 0;
+    Appointment appointment, target;
+    u32 userIdx = 0;
+    std::wstring name;
+    Type userType = Type::Patient;
+    Frequency frequency = Frequency::Weekly;
+    u8 interval = 0;
+    u16 count = 0, occurrence = 0;
+    u32 year = 0;
+
+    Event(const EventType, const Appointment& appointment = Appointment());
+};
+
+struct AuditState {
+    std::vector<User> doctors, patients;
+    std::vector<std::shared_ptr<Appointment>> appointments;
+    std::vector<std::shared_ptr<Recurrence>> recurrences;
+
+    void Apply(const Event&);
+
+private:
+    std::unordered_multimap<u64, u32> positions;
+    bool indexed = false;
+
+    static u64 key(const Appointment&);
+    u32 find(const Appointment&);
+    std::vector<std::shared_ptr<Recurrence>>::iterator findRecurrence(const Appointment&);
+};
+
+class Journal {
+    struct Checkpoint {
+        u64 sequence, time, offset;
+    };
+
+    static const u32 Magic = 0x454E4C43;
+    static const u32 Version = 1;
+    static const u64 SnapshotInterval = 1024;
+    static const u64 DenseCheckpoints = 8;
+
+    const std::string EventsFile, CheckpointsFile, SnapshotPrefix;
+    std::vector<Checkpoint> checkpoints;
+    u64 sequence = 0, end = 0, lastTime = 0;
+    bool opened = false;
+
+    void open();
+    void saveEvent(std::ostream&, const Event&) const;
+    Event loadEvent(std::istream&) const;
+    std::string snapshotFile(const u64) const;
+    void saveCheckpoint(std::ostream&, const Checkpoint&) const;
+    void prune();
+
+public:
+    static const u32 None = 0xFFFFFFFF;
+
+    Journal(const std::string&);
+
+    bool Append(Event);
+    std::string SnapshotFile();
+    void AddCheckpoint();
+    bool Reconstruct(const u64, AuditState&);
+    u64 FirstTime();
+};
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include "utils.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+enum class Counter {
+    SaveCalls, FullLoads,
+    AppointmentsCreated, AppointmentsDeleted,
+    WaitlistBookings,
+    Count
+};
+
+enum class Timer {
+    LoadData, SaveData, LoadDirectory,
+    IsValidName, PickUser, Audit,
+    Count
+};
+
+class Metrics {
+    static const u32 BucketCount = 13;
+    static const u64 BucketBounds[BucketCount - 1];
+
+    struct Histogram {
+        std::array<std::atomic<u64>, BucketCount> buckets {};
+        std::atomic<u64> count {0}, sum {0};
+    };
+
+    std::array<std::atomic<u64>, static_cast<u32>(Counter::Count)> counters {};
+    std::array<Histogram, static_cast<u32>(Timer::Count)> histograms;
+
+    Metrics() = default;
+
+public:
+    static Metrics& Instance();
+
+    void Increment(const Counter);
+    void Observe(const Timer, const u64);
+
+    std::string Prometheus() const;
+    void WritePrometheus(const std::string&) const;
+};
+
+class ScopedTimer {
+    const Timer timer;
+    const std::chrono::steady_clock::time_point start;
+
+public:
+    ScopedTimer(const Timer);
+    ~ScopedTimer();
+};
+
+class MetricsExporter {
+    const std::string File;
+    const std::chrono::seconds Interval;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+    std::thread worker;
+
+    void run();
+
+public:
+    MetricsExporter(const std::string&, const std::chrono::seconds);
+    ~MetricsExporter();
+};
\ No newline at end of file
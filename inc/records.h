@@ -0,0 +1,47 @@
+#pragma once
+#include "schema.h"
+#include "waitlist.h"
+
+template <>
+struct Schema<Date> {
+    static constexpr auto Fields = std::make_tuple(&Date::day, &Date::month, &Date::year);
+};
+
+template <>
+struct VarintPacking<Date> {
+    static u64 Pack(const Date& date) {
+        return static_cast<u64>(date.year) << 16 | static_cast<u64>(date.month) << 8 | date.day;
+    }
+
+    static Date Unpack(const u64 key) {
+        return Date(key & 0xFF, (key >> 8) & 0xFF, static_cast<u32>(key >> 16));
+    }
+};
+
+template <>
+struct Schema<Appointment> {
+    static constexpr auto Fields = std::make_tuple(&Appointment::date, &Appointment::doctorIdx, &Appointment::patientIdx, &Appointment::start, &Appointment::duration);
+};
+
+struct UntimedAppointmentSchema {
+    static constexpr auto Fields = std::make_tuple(&Appointment::date, &Appointment::doctorIdx, &Appointment::patientIdx);
+};
+
+struct DoctorSchema {
+    static constexpr auto Fields = std::make_tuple(&User::name, &User::password, &User::type);
+};
+
+struct PatientSchema {
+    static constexpr auto Fields = std::make_tuple(&User::name, &User::password);
+};
+
+template <>
+struct Schema<Recurrence> {
+    static constexpr auto Fields = std::make_tuple(&Recurrence::first, &Recurrence::frequency, &Recurrence::interval, &Recurrence::count);
+};
+
+template <>
+struct Schema<WaitlistEntry> {
+    static constexpr auto Fields = std::make_tuple(&WaitlistEntry::patientIdx, &WaitlistEntry::doctorIdx, &WaitlistEntry::specialization, &WaitlistEntry::date,
+                                                   &WaitlistEntry::start, &WaitlistEntry::urgency, &WaitlistEntry::requested, &WaitlistEntry::status);
+};
\ No newline at end of file
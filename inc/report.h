@@ -0,0 +1,48 @@
+#pragma once
+#include "data.h"
+#include <vector>
+#include <array>
+#include <unordered_map>
+
+class Report {
+    // Week and day counts are sparse so memory follows the appointments rather than the length of the range
+    struct Partial {
+        std::vector<std::unordered_map<u32, u64>> weeks;
+        std::vector<u64> weekdays;
+        std::unordered_map<u32, u64> days;
+        std::vector<std::vector<u32>> patients;
+    };
+
+    struct Row {
+        std::wstring name;
+        Type type;
+        u64 appointments, patients, doctors;
+        u64 busiestWeek, busiestWeekCount;
+        u8 busiestWeekday;
+    };
+
+    static const u64 AppointmentChunk = 65536;
+
+    const std::vector<User>& doctors;
+    const i32 first, last;
+    const u32 weekCount;
+
+    Partial totals;
+    std::vector<Row> doctorRows, specializationRows;
+
+    Partial makePartial() const;
+    void aggregate(const std::vector<std::shared_ptr<Appointment>>&, Partial&, const u64, const u64) const;
+    void merge(Partial&);
+    Row makeRow(const std::wstring&, const Type, const std::vector<u32>&) const;
+    double perWeek(const Row&) const;
+
+public:
+    Report(const std::vector<User>&, const Date&, const Date&);
+
+    void Add(const std::vector<std::shared_ptr<Appointment>>&);
+    void AddSeries(const std::vector<std::shared_ptr<Recurrence>>&);
+    void Finish();
+
+    void PrintTable(std::wostream&) const;
+    void PrintCsv(std::wostream&) const;
+};
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include "clinic.h"
+#include <memory>
+#include <unordered_map>
+
+struct Route {
+    std::wstring name;
+    std::string site;
+};
+
+template <>
+struct Schema<Route> {
+    static constexpr auto Fields = std::make_tuple(&Route::name, &Route::site);
+};
+
+class Router {
+    static const u32 RoutesMagic = 0x524E4C43;
+    static const u32 RoutesVersion = 1;
+
+    static const u32 MinimumUsernameLength = 5;
+    static const u32 MaximumUsernameLength = 20;
+
+    const std::wstring ErrorColor = getCol({ 255, 0, 0 });
+    const std::wstring SelectedColor = getCol({ 245, 212, 66 });
+    const std::wstring UnselectedColor = getCol({ 112, 109, 96 });
+
+    const std::string SaveFile, SitesDir, RoutesFile;
+    std::vector<std::string> sites;
+    std::vector<std::unique_ptr<Clinic>> shards;
+    std::unordered_multimap<std::wstring, u32> routes;
+    bool routed = false, rebuilt = false;
+
+    std::string saveFile(const u32) const;
+    std::wstring siteName(const u32) const;
+    std::vector<std::string> populatedSites() const;
+    void ensureRoutes();
+    void saveRoutes() const;
+    void rebuildRoutes();
+    void addRoute(const std::wstring&, const u32);
+    std::vector<u32> resolve(const std::wstring&, const bool);
+    u32 pickSite(const std::vector<u32>&) const;
+    void enter(const bool);
+
+public:
+    static const u32 None = 0xFFFFFFFF;
+
+    Router(const std::string&, const std::string&);
+
+    u32 Find(const std::string&) const;
+    Clinic& Shard(const u32);
+    std::vector<std::vector<OpenSlots>> FreeSlots(const Type, const Date&, const u16);
+    void PrintFreeSlots(const Type, const Date&, const u16);
+    void MainMenu();
+};
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+#include "utils.h"
+#include <tuple>
+#include <cstring>
+#include <string>
+
+// Schema<T>::Fields lists member pointers in on-disk order, every encoder below is generated from it
+template <typename T>
+struct Schema;
+
+template <typename T, typename = void>
+struct HasSchema : std::false_type {};
+
+template <typename T>
+struct HasSchema<T, std::void_t<decltype(Schema<T>::Fields)>> : std::true_type {};
+
+// VarintPacking<T> folds a nested record into a single varint in the compact encoding
+template <typename T>
+struct VarintPacking;
+
+template <typename T, typename = void>
+struct HasVarintPacking : std::false_type {};
+
+template <typename T>
+struct HasVarintPacking<T, std::void_t<decltype(VarintPacking<T>::Pack)>> : std::true_type {};
+
+template <typename C, typename M>
+M memberType(M C::*);
+
+template <typename P>
+using FieldType = decltype(memberType(std::declval<P>()));
+
+template <typename S>
+constexpr u64 recordSize();
+
+template <typename T>
+constexpr u64 fieldSize() {
+    if constexpr (HasSchema<T>::value) return recordSize<Schema<T>>();
+    else {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Fixed-size records may only hold scalars and nested records");
+        return sizeof(T);
+    }
+}
+
+template <typename S>
+constexpr u64 recordSize() {
+    return std::apply([](const auto... fields) { return (fieldSize<FieldType<decltype(fields)>>() + ...); }, S::Fields);
+}
+
+template <typename T, typename S = Schema<T>>
+void writeRecord(std::ostream&, const T&);
+
+template <typename T, typename S = Schema<T>>
+void readRecord(std::istream&, T&);
+
+template <typename T>
+void writeField(std::ostream& os, const T& value) {
+    if constexpr (std::is_same_v<T, std::string>) writeStr(os, value);
+    else if constexpr (std::is_same_v<T, std::wstring>) writeWstr(os, value);
+    else if constexpr (HasSchema<T>::value) writeRecord(os, value);
+    else writeBF<T>(os, value);
+}
+
+template <typename T>
+void readField(std::istream& is, T& value) {
+    if constexpr (std::is_same_v<T, std::string>) value = readStr(is);
+    else if constexpr (std::is_same_v<T, std::wstring>) value = readWstr(is);
+    else if constexpr (HasSchema<T>::value) readRecord(is, value);
+    else value = readBF<T>(is);
+}
+
+template <typename T, typename S>
+void writeRecord(std::ostream& os, const T& record) {
+    std::apply([&](const auto... fields) { (writeField(os, record.*fields), ...); }, S::Fields);
+}
+
+template <typename T, typename S>
+void readRecord(std::istream& is, T& record) {
+    std::apply([&](const auto... fields) { (readField(is, record.*fields), ...); }, S::Fields);
+}
+
+template <typename T, typename S = Schema<T>>
+char* packRecord(char*, const T&);
+
+template <typename T, typename S = Schema<T>>
+const char* unpackRecord(const char*, T&);
+
+template <typename T>
+char* packField(char* out, const T& value) {
+    if constexpr (HasSchema<T>::value) return packRecord(out, value);
+    else {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+}
+
+template <typename T>
+const char* unpackField(const char* in, T& value) {
+    if constexpr (HasSchema<T>::value) return unpackRecord(in, value);
+    else {
+        std::memcpy(&value, in, sizeof(T));
+        return in + sizeof(T);
+    }
+}
+
+template <typename T, typename S>
+char* packRecord(char* out, const T& record) {
+    static_assert(recordSize<S>() > 0);
+    std::apply([&](const auto... fields) { ((out = packField(out, record.*fields)), ...); }, S::Fields);
+    return out;
+}
+
+template <typename T, typename S>
+const char* unpackRecord(const char* in, T& record) {
+    static_assert(recordSize<S>() > 0);
+    std::apply([&](const auto... fields) { ((in = unpackField(in, record.*fields)), ...); }, S::Fields);
+    return in;
+}
+
+template <typename S>
+struct TailSchema {
+    static constexpr auto Fields = std::apply([](const auto, const auto... rest) { return std::make_tuple(rest...); }, S::Fields);
+};
+
+template <typename T, typename S = Schema<T>>
+void writeVarintRecord(std::ostream&, const T&);
+
+template <typename T, typename S = Schema<T>>
+void readVarintRecord(std::istream&, T&);
+
+template <typename T>
+void writeVarintField(std::ostream& os, const T& value) {
+    if constexpr (HasVarintPacking<T>::value) writeVarint(os, VarintPacking<T>::Pack(value));
+    else if constexpr (std::is_same_v<T, std::string>) {
+        writeVarint(os, value.size());
+        os.write(value.data(), value.size());
+    }
+    else if constexpr (std::is_same_v<T, std::wstring>) {
+        writeVarint(os, value.size());
+        for (const wchar_t wc : value) writeVarint(os, static_cast<u32>(wc));
+    }
+    else if constexpr (HasSchema<T>::value) writeVarintRecord(os, value);
+    else writeVarint(os, static_cast<u64>(value));
+}
+
+template <typename T>
+void readVarintField(std::istream& is, T& value) {
+    if constexpr (HasVarintPacking<T>::value) value = VarintPacking<T>::Unpack(readVarint(is));
+    else if constexpr (std::is_same_v<T, std::string>) {
+        value.resize(readCount(is));
+        is.read(value.data(), value.size());
+    }
+    else if constexpr (std::is_same_v<T, std::wstring>) {
+        value.resize(readCount(is));
+        for (wchar_t& wc : value) wc = static_cast<wchar_t>(readVarint(is));
+    }
+    else if constexpr (HasSchema<T>::value) readVarintRecord(is, value);
+    else value = static_cast<T>(readVarint(is));
+}
+
+template <typename T, typename S>
+void writeVarintRecord(std::ostream& os, const T& record) {
+    std::apply([&](const auto... fields) { (writeVarintField(os, record.*fields), ...); }, S::Fields);
+}
+
+template <typename T, typename S>
+void readVarintRecord(std::istream& is, T& record) {
+    std::apply([&](const auto... fields) { (readVarintField(is, record.*fields), ...); }, S::Fields);
+}
\ No newline at end of file
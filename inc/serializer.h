@@ -1,20 +1,104 @@
 #pragma once
-#include "data.h"
+#include "doctor_index.h"
+#include "records.h"
 #include <vector>
 
 class Serializer {
+	struct DirectoryEntry {
+		u64 record;
+		u32 listStart, listCount;
+	};
+
+	struct Chunk {
+		u64 begin, end;
+		std::string data;
+	};
+
+	struct Block {
+		u64 rawSize;
+		u32 checksum;
+		std::string compressed;
+	};
+
+	static const u32 Magic = 0x434E4C43;
+	static const u32 Version = 5;
+	static const u32 TimedVersion = 3;
+	static const u32 RecurringVersion = 4;
+	static const u32 MovedRecordVersion = 5;
+	static const u32 AppointmentSize = 18;
+	static const u32 UntimedAppointmentSize = 14;
+	static const u32 SnapshotMagic = 0x534E4C43;
+	static const u32 SnapshotVersion = 5;
+	static const u32 TimedSnapshotVersion = 2;
+	static const u32 RecurringSnapshotVersion = 3;
+	static const u32 CheckedSnapshotVersion = 4;
+	static const u32 MovedRecordSnapshotVersion = 5;
+	static const u32 ArchiveMagic = 0x414E4C43;
+	static const u32 ArchiveVersion = 1;
+	static const u32 WaitlistMagic = 0x574E4C43;
+	static const u32 WaitlistVersion = 1;
+	static const u64 UserChunk = 4096;
+	static const u64 AppointmentChunk = 65536;
+	static const u32 MaximumYearDigits = 9;
+
+	static_assert(recordSize<Schema<Appointment>>() == AppointmentSize);
+	static_assert(recordSize<UntimedAppointmentSchema>() == UntimedAppointmentSize);
+	static_assert(std::get<0>(Schema<Appointment>::Fields) == &Appointment::date && std::get<0>(UntimedAppointmentSchema::Fields) == &Appointment::date,
+	              "Compact appointments delta-code the date ahead of the remaining fields");
+
 	const std::string SaveFile;
+	std::vector<DirectoryEntry> doctorEntries, patientEntries;
+	u64 listsOffset, appointmentsOffset;
+	bool timedRows = true;
+
+	void saveUser(std::ostream&, const User&, const bool) const;
+	User loadUser(std::istream&, const bool) const;
+	std::string packAppointments(const std::vector<std::shared_ptr<Appointment>>&, const u64, const u64) const;
+	void unpackAppointments(const char*, const bool, std::vector<std::shared_ptr<Appointment>>&, const u64, const u64) const;
+	void saveAppointments(std::ostream&, const std::vector<std::shared_ptr<Appointment>>&) const;
+	void loadAppointments(std::istream&, std::vector<std::shared_ptr<Appointment>>&, const bool) const;
+	void saveRecurrences(std::ostream&, const std::vector<std::shared_ptr<Recurrence>>&) const;
+	void loadRecurrences(std::istream&, std::vector<std::shared_ptr<Recurrence>>&, const bool) const;
+	std::string archiveFile(const u32) const;
+	std::string pendingFile(const u32) const;
+	std::vector<u32> scanYears(const std::string&) const;
+	std::string waitlistFile() const;
+	void indexUsers(const std::vector<User>&, const std::vector<std::shared_ptr<Appointment>>&, const bool, std::vector<DirectoryEntry>&, std::vector<u32>&) const;
+	void encodeUsers(const std::vector<User>&, const bool, Chunk&, std::vector<DirectoryEntry>&) const;
+	void encodeAppointments(const std::vector<std::shared_ptr<Appointment>>&, Chunk&) const;
+	void writeChunks(std::ostream&, const std::vector<Chunk>&, std::vector<DirectoryEntry>*) const;
+	void decodeUsers(const std::string&, std::vector<User>&, const std::vector<DirectoryEntry>&, const bool, const u64, const u64) const;
+	void decodeAppointments(const std::string&, const u64, const bool, std::vector<std::shared_ptr<Appointment>>&, const u64, const u64) const;
+	void saveDirectory(std::ostream&, const std::vector<User>&, const std::vector<DirectoryEntry>&, const bool) const;
+	void loadDirectory(std::istream&, std::vector<User>&, std::vector<DirectoryEntry>&, const bool) const;
 
-	void saveDate(std::ofstream&, const Date&) const;
-	void savePatient(std::ofstream&, const User&) const;
-	void saveDoctor(std::ofstream&, const User&) const;
-	Date loadDate(std::ifstream&) const;
-	User loadDoctor(std::ifstream&) const;
-	User loadPatient(std::ifstream&) const;
-	void loadAppointments(std::ifstream&, std::vector<std::shared_ptr<Appointment>>&) const;
+	std::string packBlock(const std::string&) const;
+	bool readBlock(std::istream&, const bool, Block&) const;
+	bool unpackBlock(const Block&, const bool, std::string&) const;
+	void saveCompactUser(std::ostream&, const User&, const bool) const;
+	bool loadCompactUser(std::istream&, const bool, User&) const;
+	std::string encodeCompactUsers(const std::vector<User>&, const bool) const;
+	std::string encodeCompactAppointments(const std::vector<std::shared_ptr<Appointment>>&) const;
+	std::string encodeCompactRecurrences(const std::vector<std::shared_ptr<Recurrence>>&) const;
+	bool decodeCompactUsers(const std::string&, std::vector<User>&, const bool) const;
+	bool decodeCompactAppointments(const std::string&, std::vector<std::shared_ptr<Appointment>>&, const bool) const;
+	bool decodeCompactRecurrences(const std::string&, std::vector<std::shared_ptr<Recurrence>>&, const bool) const;
+	bool loadSnapshot(std::istream&, std::vector<User>&, std::vector<User>&, std::vector<std::shared_ptr<Appointment>>&, std::vector<std::shared_ptr<Recurrence>>&) const;
 
 public:
 	Serializer(const std::string&);
-	void SaveData(const std::vector<User>&, const std::vector<User>&, const std::vector<std::shared_ptr<Appointment>>&) const;
-	void LoadData(std::vector<User>&, std::vector<User>&, std::vector<std::shared_ptr<Appointment>>&) const;
+	void SaveData(const std::vector<User>&, const std::vector<User>&, const std::vector<std::shared_ptr<Appointment>>&, const std::vector<std::shared_ptr<Recurrence>>&) const;
+	bool LoadData(std::vector<User>&, std::vector<User>&, std::vector<std::shared_ptr<Appointment>>&, std::vector<std::shared_ptr<Recurrence>>&, DoctorIndex&) const;
+	void SaveSnapshot(const std::string&, const std::vector<User>&, const std::vector<User>&, const std::vector<std::shared_ptr<Appointment>>&, const std::vector<std::shared_ptr<Recurrence>>&) const;
+	bool LoadDirectory(std::vector<User>&, std::vector<User>&);
+	User LoadUser(const bool, const u32) const;
+	void LoadUserAppointments(const bool, const u32, std::vector<std::shared_ptr<Appointment>>&, std::vector<u32>&) const;
+	void SaveArchive(const u32, const std::vector<std::shared_ptr<Appointment>>&) const;
+	void LoadArchive(const u32, std::vector<std::shared_ptr<Appointment>>&) const;
+	void CommitArchive(const u32) const;
+	void DiscardArchive(const u32) const;
+	std::vector<u32> ArchiveYears() const;
+	std::vector<u32> PendingArchives() const;
+	void SaveWaitlist(const Waitlist&) const;
+	void LoadWaitlist(Waitlist&) const;
 };
\ No newline at end of file
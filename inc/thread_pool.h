@@ -0,0 +1,34 @@
+#pragma once
+#include "utils.h"
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+class ThreadPool {
+    std::vector<std::thread> workers;
+    std::queue<std::packaged_task<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void work();
+
+public:
+    ThreadPool(const u32);
+    ~ThreadPool();
+
+    u32 Size() const;
+    u32 ChunkCount(const u64, const u64) const;
+
+    std::future<void> Submit(std::function<void()>);
+    // Chunked helpers block on their futures, so call them from outside pool tasks only
+    std::vector<std::future<void>> SubmitChunks(const u64, const u64, const std::function<void(const u32, const u64, const u64)>&);
+    void ParallelFor(const u64, const u64, const std::function<void(const u32, const u64, const u64)>&);
+
+    static void Wait(std::vector<std::future<void>>&);
+    static ThreadPool& Shared();
+};
\ No newline at end of file
@@ -7,10 +7,14 @@
 #include <sstream>
 #include <filesystem>
 #include <fstream>
+#include <type_traits>
 
 namespace fs = std::filesystem;
 
+using u64 = uint64_t;
 using u32 = uint32_t;
+using u16 = uint16_t;
+using i64 = int64_t;
 using i32 = int32_t;
 using u8 = uint8_t;
 
@@ -27,6 +31,8 @@ enum class Type {
     Patient
 };
 
+static constexpr u32 SpecializationCount = static_cast<u32>(Type::Patient);
+
 std::wstring getTypeWstr(const Type);
 
 std::wstring stw(const std::string&);
@@ -34,15 +40,38 @@ std::wstring stw(const std::string&);
 void clearScreen();
 
 template <typename T>
-T readBF(std::ifstream&);
+T readBF(std::istream& is) {
+    static_assert(std::is_trivially_copyable_v<T>, "readBF needs a trivially copyable type");
+    T n {};
+    is.read(reinterpret_cast<char*>(&n), sizeof(T));
+    return n;
+}
+
 template <typename T>
-void writeBF(std::ofstream&, T);
+void writeBF(std::ostream& os, const T n) {
+    static_assert(std::is_trivially_copyable_v<T>, "writeBF needs a trivially copyable type");
+    os.write(reinterpret_cast<const char*>(&n), sizeof(T));
+}
+
+void writeStr(std::ostream&, const std::string&);
+std::string readStr(std::istream&);
+
+void writeWstr(std::ostream&, const std::wstring&);
+std::wstring readWstr(std::istream&);
+
+struct MemoryBuffer : std::streambuf {
+    MemoryBuffer(const char*, const char*);
+
+protected:
+    pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) override;
+    pos_type seekpos(pos_type, std::ios_base::openmode) override;
+};
 
-void writeStr(std::ofstream&, const std::string&);
-std::string readStr(std::ifstream&);
+std::string readFile(const std::string&);
 
-void writeWstr(std::ofstream&, const std::wstring&);
-std::wstring readWstr(std::ifstream&);
+void writeVarint(std::ostream&, u64);
+u64 readVarint(std::istream&);
+u64 readCount(std::istream&);
 
 
 struct RGB {
@@ -0,0 +1,51 @@
+#pragma once
+#include "data.h"
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+enum class WaitStatus : u8 { Waiting, Booked, Withdrawn, Notified };
+
+struct WaitlistEntry {
+    u32 patientIdx, doctorIdx;
+    Type specialization;
+    Date date;
+    u16 start;
+    u8 urgency;
+    u64 requested;
+    WaitStatus status;
+};
+
+class Waitlist {
+    using Key = std::pair<u32, i32>;
+
+    static const u32 CompactThreshold = 1024;
+
+    std::vector<WaitlistEntry> entries;
+    std::map<Key, std::vector<u32>> doctorQueues, specializationQueues;
+    std::unordered_map<u32, std::vector<u32>> patientIds;
+    u64 nextRequest = 0;
+    u32 settled = 0;
+
+    bool before(const u32, const u32) const;
+    std::vector<u32>& queue(const WaitlistEntry&);
+    void push(const u32);
+    void track(const u32);
+    u32 top(std::map<Key, std::vector<u32>>&, const Key&);
+    void compact();
+
+public:
+    static const u32 AnyDoctor = 0xFFFFFFFF;
+    static const u32 None = 0xFFFFFFFF;
+
+    static bool Settled(const WaitStatus);
+
+    void Add(const u32, const u32, const Type, const Date&, const u8);
+    void Restore(const WaitlistEntry&);
+    void Withdraw(const u32);
+    void Notify(const u32);
+    u32 Match(const u32, const Type, const Date&, const u16);
+
+    const std::vector<WaitlistEntry>& Entries() const;
+    std::vector<u32> PatientEntries(const u32) const;
+};
\ No newline at end of file
@@ -1,17 +1,59 @@
 #include "clinic.h"
+#include "metrics.h"
+#include "report.h"
 #include <algorithm>
 
-void Clinic::saveData() const {
-	serializer.SaveData(doctors, patients, appointments);
+void Clinic::saveData() {
+    Metrics::Instance().Increment(Counter::SaveCalls);
+    ensureLoaded();
+	serializer.SaveData(doctors, patients, appointments, recurrences);
+    serializer.SaveWaitlist(waitlist);
+}
+
+void Clinic::record(const Event& event) {
+    if (!journal.Append(event)) return;
+
+    ensureLoaded();
+    serializer.SaveSnapshot(journal.SnapshotFile(), doctors, patients, appointments, recurrences);
+    journal.AddCheckpoint();
 }
 
 void Clinic::initializeData() {
     patients = DefaultPatients;
     doctors = DefaultDoctors;
     appointments = DefaultAppointments;
+    doctorIndex.Build(doctors, appointments, recurrences);
+}
+
+void Clinic::loadData() {
+    if (serializer.LoadData(doctors, patients, appointments, recurrences, doctorIndex)) return;
+
+    std::wcerr << ErrorColor << L"The save file is damaged, refusing to continue with partial data" << getCol() << std::endl;
+    std::exit(1);
+}
+
+void Clinic::ensureLoaded() {
+    if (fullyLoaded) return;
+
+    Metrics::Instance().Increment(Counter::FullLoads);
+    doctors.clear();
+    patients.clear();
+    loadData();
+
+    const u32 sz = CurrentPositions.size();
+    for (u32 i=0; i < sz; ++i) appointments[CurrentPositions[i]] = CurrentAppointments[i];
+
+    if (sz) doctorIndex.Build(doctors, appointments, recurrences);
+    CurrentPositions.clear();
+    fullyLoaded = true;
 }
 
 void Clinic::fetchAppointments(const bool isDoctor) {
+    if (!fullyLoaded) {
+        serializer.LoadUserAppointments(isDoctor, CurrentIdx, CurrentAppointments, CurrentPositions);
+        return;
+    }
+
     const u32 sz = appointments.size();
     CurrentAppointments.reserve(sz);
 
@@ -20,6 +62,49 @@ void Clinic::fetchAppointments(const bool isDoctor) {
             CurrentAppointments.push_back(appointments[i]);
 }
 
+void Clinic::recoverArchives() {
+    const std::vector<u32> pending = serializer.PendingArchives();
+    if (pending.empty()) return;
+
+    ensureLoaded();
+
+    for (const u32 year : pending) {
+        const bool saved = std::none_of(appointments.begin(), appointments.end(), [year](const std::shared_ptr<Appointment>& appointment) {
+            return appointment->date.year == year;
+            });
+
+        saved ? serializer.CommitArchive(year) : serializer.DiscardArchive(year);
+    }
+}
+
+void Clinic::loadArchive() {
+    for (const u32 year : serializer.ArchiveYears())
+        if (archive.find(year) == archive.end())
+            serializer.LoadArchive(year, archive[year]);
+}
+
+void Clinic::showHistory(const bool isDoctor) {
+    loadArchive();
+    clearScreen();
+
+    std::wcout << L"Appointment History\n\n";
+    u32 count = 0;
+
+    for (const auto& [year, yearAppointments] : archive)
+        for (const std::shared_ptr<Appointment>& appointment : yearAppointments) {
+            if ((isDoctor ? doctors[appointment->doctorIdx].name : patients[appointment->patientIdx].name) != CurrentUser->name)
+                continue;
+
+            std::wcout << UnselectedColor
+                << ++count << L") " << (isDoctor ? L"Patient: " : L"Doctor: ") << (isDoctor ? patients[appointment->patientIdx].name : doctors[appointment->doctorIdx].name)
+                << L"\nDate: " << appointment->date.str() << L' ' << appointment->timeStr()
+                << L"\n\n" << getCol();
+        }
+
+    if (count == 0) std::wcout << SelectedColor << L"No archived appointments\n" << getCol();
+    getCharV();
+}
+
 void Clinic::modifyDate(Date& date) const {
     u8 idx = 0;
 
@@ -95,33 +180,138 @@ void Clinic::modifyDate(Date& date) const {
     }
 }
 
-std::pair<std::shared_ptr<User>, u32> Clinic::pickUser(const bool isDoctor, const Date& date) const {
+void Clinic::modifyTime(u16& start, u16& duration) const {
     u8 idx = 0;
 
-    std::vector<User> freeDoctors;
-    
-    if(!isDoctor) {
-        const u32 sz = doctors.size();
-
-        std::vector<bool> freeDoctorFlags (sz, true);
-        
-        for(std::shared_ptr<Appointment> appointment : appointments)
-            if(appointment->date == date) 
-                freeDoctorFlags[appointment->doctorIdx] = false;
-        
-        freeDoctors.reserve(sz);
-        for(u32 i=0; i < sz; ++i) {
-            if(freeDoctorFlags[i])
-                freeDoctors.push_back(doctors[i]);
+    while (true) {
+        clearScreen();
+
+        std::wcout << L"Select which part to modify: "
+            << (idx == 0 ? SelectedColor : UnselectedColor) << (start / 60 < 10 ? L"0" : L"") << start / 60 << getCol() << L':'
+            << (idx == 1 ? SelectedColor : UnselectedColor) << (start % 60 < 10 ? L"0" : L"") << start % 60 << getCol() << L" for "
+            << (idx == 2 ? SelectedColor : UnselectedColor) << duration << getCol() << L" minutes";
+
+        const char c = getChar();
+
+        if (std::isdigit(c)) {
+            const u8 digit = c - '0';
+
+            if (digit < 1 || digit > 3) {
+                clearScreen();
+                std::wcout << ErrorColor << L"Error: Digit input must be between 1-3\n" << getCol();
+                getCharV();
+                continue;
+            }
+
+            idx = digit - 1;
+        }
+
+        switch (c) {
+        case 'w': case 'a': idx = idx == 0 ? 2 : idx - 1; break;
+        case 's': case 'd': idx = idx == 2 ? 0 : idx + 1; break;
+
+        case 'q':
+        if (start + duration > ClosingTime) {
+            clearScreen();
+            std::wcout << ErrorColor << L"Error: Appointment must end by " << Appointment::timeStr(ClosingTime) << L'\n' << getCol();
+            getCharV();
+            continue;
+        }
+        return;
+
+        default:
+            std::wcout << L"\n\nEnter a new " << (idx == 0 ? L"hour" : idx == 1 ? L"minute" : L"duration") << L" (between "
+                << (idx == 0 ? std::to_wstring(OpeningTime / 60) + L'-' + std::to_wstring(ClosingTime / 60 - 1) : idx == 1 ? L"0-59" : L"1-" + std::to_wstring(MaximumDuration)) << L"): ";
+
+            u32 input;
+            std::cin >> input;
+            clearInputBuffer();
+
+            switch (idx) {
+                case 0:
+                if (!(input >= OpeningTime / 60 && input < ClosingTime / 60)) {
+                    std::wcout << ErrorColor << L"Invalid hour input, it must be between " << OpeningTime / 60 << L" and " << ClosingTime / 60 - 1 << getCol();
+                    getCharV();
+                    continue;
+                }
+
+                start = input * 60 + start % 60;
+                break;
+
+                case 1:
+                if (!(input < 60)) {
+                    std::wcout << ErrorColor << L"Invalid minute input, it must be between 0 and 59" << getCol();
+                    getCharV();
+                    continue;
+                }
+
+                start = start / 60 * 60 + input;
+                break;
+
+                case 2:
+                if (!(input > 0 && input <= MaximumDuration)) {
+                    std::wcout << ErrorColor << L"Invalid duration input, it must be between 1 and " << MaximumDuration << getCol();
+                    getCharV();
+                    continue;
+                }
+
+                duration = input;
+                break;
+            } break;
+        }
+    }
+}
+
+bool Clinic::pickSlot(const u32 doctorIdx, const Date& date, const u16 duration, u16& start, const Appointment* ignore) const {
+    const std::vector<u16> slots = doctorIndex.FreeSlots(doctorIdx, date, OpeningTime, ClosingTime, SlotStep, duration, ignore);
+    u32 idx = 0;
+
+    if (slots.empty()) {
+        clearScreen();
+        std::wcout << ErrorColor << doctors[doctorIdx].name << L" has no free slots on " << date.str() << L'\n' << getCol();
+        getCharV();
+        return false;
+    }
+
+    while (true) {
+        clearScreen();
+        std::wcout << L"Free slots for " << doctors[doctorIdx].name << L" on " << date.str() << L"\n\n";
+
+        const u32 sz = slots.size();
+        for (u32 i=0; i < sz; ++i)
+            std::wcout << (idx==i ? SelectedColor : UnselectedColor)
+                       << Appointment::timeStr(slots[i]) << L'-' << Appointment::timeStr(slots[i] + duration)
+                       << L'\n' << getCol();
+
+        switch (getChar()) {
+            case 'w': case 'a': idx = idx == 0 ? sz - 1 : idx - 1; break;
+            case 's': case 'd': idx = idx == sz - 1 ? 0 : idx + 1; break;
+
+            case 'q': return false;
+
+            default:
+            start = slots[idx];
+            return true;
         }
     }
+}
+
+std::pair<std::shared_ptr<User>, u32> Clinic::pickUser(const bool isDoctor, const Date& date, const u16 start, const u16 duration) const {
+    u8 idx = 0;
+    u32 filter = SpecializationCount;
 
-    const u32 fdsz = freeDoctors.size();
+    const auto findFreeDoctors = [this, &date, start, duration, &filter] {
+        const ScopedTimer timer (Timer::PickUser);
+        return filter == SpecializationCount ? doctorIndex.FreeDoctors(date, start, duration) : doctorIndex.FreeDoctors(static_cast<Type>(filter), date, start, duration);
+    };
+
+    std::vector<u32> freeDoctors;
+    if (!isDoctor) freeDoctors = findFreeDoctors();
 
     while (true) {
         clearScreen();
 
-        const u32 sz = !isDoctor ? doctors.size() : patients.size();
+        const u32 sz = isDoctor ? patients.size() : freeDoctors.size();
 
         if(isDoctor)
             for (u32 i=0; i < sz; ++i)
@@ -129,19 +319,35 @@ std::pair<std::shared_ptr<User>, u32> Clinic::pickUser(const bool isDoctor, cons
                            << i + 1 << L") " << patients[i].name
                            << L'\n' << getCol();
 
-        else
-            for(u32 i=0; i < fdsz; ++i)
+        else {
+            std::wcout << L"Specialization filter: " << (filter == SpecializationCount ? L"All" : getTypeWstr(static_cast<Type>(filter)))
+                       << L" (press f to change)\n\n";
+
+            if (sz == 0) std::wcout << ErrorColor << L"No free doctors for this time\n" << getCol();
+
+            for(u32 i=0; i < sz; ++i)
                 std::wcout << (idx==i ? SelectedColor : UnselectedColor)
-                           << i + 1 << L") " << freeDoctors[i].name
-                           << L"\nSpecialization: " << getTypeWstr(freeDoctors[i].type)
+                           << i + 1 << L") " << doctors[freeDoctors[i]].name
+                           << L"\nSpecialization: " << getTypeWstr(doctors[freeDoctors[i]].type)
                            << L'\n' << getCol();
+        }
 
         const char c = getChar();
 
+        if (!isDoctor && c == 'f') {
+            filter = filter == SpecializationCount ? 0 : filter + 1;
+            freeDoctors = findFreeDoctors();
+            idx = 0;
+            continue;
+        }
+
+        if (c == 'q') return std::make_pair(nullptr, 0);
+        if (sz == 0) continue;
+
         if (std::isdigit(c)) {
             const u8 digit = c - '0';
 
-            if (digit < 1 || digit > (isDoctor ? sz : fdsz)) {
+            if (digit < 1 || digit > sz) {
                 clearScreen();
                 std::wcout << ErrorColor << L"Error: Digit input must be between 1-" << sz << L'\n' << getCol();
                 getCharV();
@@ -153,42 +359,397 @@ std::pair<std::shared_ptr<User>, u32> Clinic::pickUser(const bool isDoctor, cons
         }
 
         switch (c) {
-            case 'w': case 'a': idx = idx == 0 ? static_cast<u8>((isDoctor ? sz : fdsz) - 1) : idx - 1; break;
-            case 's': case 'd': idx = idx == (isDoctor ? sz : fdsz) - 1 ? 0 : idx + 1; break;
-
-            case 'q': return std::make_pair(nullptr, 0);
+            case 'w': case 'a': idx = idx == 0 ? static_cast<u8>(sz - 1) : idx - 1; break;
+            case 's': case 'd': idx = idx == sz - 1 ? 0 : idx + 1; break;
 
             default:
             if (isDoctor)
                 return std::make_pair(std::make_shared<User>(patients[idx]), idx);
             else
-                return std::make_pair(std::make_shared<User>(freeDoctors[idx]), std::distance(doctors.begin(), 
-                       std::find_if(doctors.begin(), doctors.end(), 
-                       [&freeDoctors, idx](const User& doctor) { return doctor.name == freeDoctors[idx].name; })));
+                return std::make_pair(std::make_shared<User>(doctors[freeDoctors[idx]]), freeDoctors[idx]);
             break;
         }
     }
 }
 
 void Clinic::createAppointment() {
+    ensureLoaded();
+
     Date date (0, 0, CurrentYear);
     modifyDate(date);
 
-    std::shared_ptr<Appointment> appointment = std::make_shared<Appointment>(date, pickUser(false, date).second, CurrentIdx);
+    u16 start = Appointment::DefaultStart, duration = Appointment::DefaultDuration;
+    modifyTime(start, duration);
+
+    const std::pair<std::shared_ptr<User>, u32> doctor = pickUser(false, date, start, duration);
+    if (!doctor.first) return;
+
+    std::shared_ptr<Appointment> appointment = std::make_shared<Appointment>(date, doctor.second, CurrentIdx, start, duration);
 
     appointments.push_back(appointment);
     CurrentAppointments.push_back(appointment);
+    doctorIndex.Book(*appointment);
+    Metrics::Instance().Increment(Counter::AppointmentsCreated);
+    record(Event(EventType::AppointmentCreated, *appointment));
 }
 
 void Clinic::deleteAppointment(const u8 idx) {
-    if (const auto t = std::find(appointments.begin(), appointments.end(), CurrentAppointments[idx]);
+    ensureLoaded();
+    const std::shared_ptr<Appointment> appointment = CurrentAppointments[idx];
+    doctorIndex.Release(*appointment);
+
+    if (const auto t = std::find(appointments.begin(), appointments.end(), appointment);
         t != appointments.end()) appointments.erase(t);
 
     CurrentAppointments.erase(CurrentAppointments.begin() + idx);
+    Metrics::Instance().Increment(Counter::AppointmentsDeleted);
+    record(Event(EventType::AppointmentDeleted, *appointment));
+    offerSlot(*appointment);
+}
+
+void Clinic::offerSlot(const Appointment& freed) {
+    if (freed.doctorIdx >= doctors.size() || !doctorIndex.IsFree(freed.doctorIdx, freed.date, freed.start, freed.duration)) return;
+
+    const u32 id = waitlist.Match(freed.doctorIdx, doctors[freed.doctorIdx].type, freed.date, freed.start);
+    if (id == Waitlist::None) return;
+
+    const std::shared_ptr<Appointment> appointment = std::make_shared<Appointment>(freed.date, freed.doctorIdx, waitlist.Entries()[id].patientIdx, freed.start, freed.duration);
+
+    appointments.push_back(appointment);
+    doctorIndex.Book(*appointment);
+
+    if ((CurrentUser->type == Type::Patient ? appointment->patientIdx : appointment->doctorIdx) == CurrentIdx) CurrentAppointments.push_back(appointment);
+    Metrics::Instance().Increment(Counter::WaitlistBookings);
+    record(Event(EventType::AppointmentCreated, *appointment));
+}
+
+void Clinic::joinWaitlist() {
+    Date date (0, 0, CurrentYear);
+    modifyDate(date);
+
+    if (!date.valid()) {
+        clearScreen();
+        std::wcout << ErrorColor << L"Error: Select a day and month to wait for\n" << getCol();
+        getCharV();
+        return;
+    }
+
+    clearScreen();
+    std::wcout << L"Wait for a specific (d)octor or any doctor of a (s)pecialization? ";
+
+    u32 doctorIdx = Waitlist::AnyDoctor;
+    Type specialization;
+
+    if (getChar() == 'd') {
+        const std::pair<std::shared_ptr<User>, u32> doctor = pickUser(false);
+        if (!doctor.first) return;
+
+        doctorIdx = doctor.second;
+        specialization = doctor.first->type;
+    }
+    else {
+        std::wcout << L"\n\n";
+        for (u32 t=0; t < SpecializationCount; ++t) std::wcout << t + 1 << L") " << getTypeWstr(static_cast<Type>(t)) << L'\n';
+        std::wcout << L"\nSelect a specialization (between 1-" << SpecializationCount << L"): ";
+
+        u32 input = 0;
+        std::cin >> input;
+        clearInputBuffer();
+
+        if (!(input > 0 && input <= SpecializationCount)) {
+            std::wcout << ErrorColor << L"Invalid specialization, it must be between 1 and " << SpecializationCount << getCol();
+            getCharV();
+            return;
+        }
+
+        specialization = static_cast<Type>(input - 1);
+    }
+
+    std::wcout << L"\nUrgency (between 1-" << MaximumUrgency << L", higher is more urgent): ";
+
+    u32 urgency = 0;
+    std::cin >> urgency;
+    clearInputBuffer();
+
+    if (!(urgency > 0 && urgency <= MaximumUrgency)) {
+        std::wcout << ErrorColor << L"Invalid urgency, it must be between 1 and " << MaximumUrgency << getCol();
+        getCharV();
+        return;
+    }
+
+    waitlist.Add(CurrentIdx, doctorIdx, specialization, date, urgency);
+    saveData();
+}
+
+void Clinic::waitlistMenu() {
+    ensureLoaded();
+    u32 idx = 0;
+
+    while (true) {
+        clearScreen();
+
+        const std::vector<u32> ids = waitlist.PatientEntries(CurrentIdx);
+        const u32 sz = ids.size();
+
+        std::wcout << L"Waitlist\n\n";
+
+        if (sz == 0) std::wcout << SelectedColor << L"Not waiting for any slot, press n to join the waitlist or q to go back\n" << getCol();
+        if (idx >= sz) idx = 0;
+
+        for (u32 i=0; i < sz; ++i) {
+            const WaitlistEntry& entry = waitlist.Entries()[ids[i]];
+
+            std::wcout << (idx == i ? SelectedColor : UnselectedColor)
+                << i + 1 << L") " << (entry.status == WaitStatus::Waiting ? L"Waiting: " : L"Booked: ")
+                << (entry.doctorIdx == Waitlist::AnyDoctor ? L"Any " + getTypeWstr(entry.specialization) : doctors[entry.doctorIdx].name)
+                << L" on " << entry.date.str()
+                << (entry.status == WaitStatus::Waiting ? L"" : L" at " + Appointment::timeStr(entry.start))
+                << L"\nUrgency: " << entry.urgency
+                << L"\n\n" << getCol();
+        }
+
+        const char c = getChar();
+
+        if (c == 'q') return;
+
+        if (c == 'n') {
+            joinWaitlist();
+            continue;
+        }
+
+        if (sz == 0) continue;
+
+        switch (c) {
+            case 'w': case 'a': idx = idx == 0 ? sz - 1 : idx - 1; break;
+            case 's': case 'd': idx = idx == sz - 1 ? 0 : idx + 1; break;
+
+            case 'y':
+            waitlist.Withdraw(ids[idx]);
+            saveData();
+            break;
+
+            default: break;
+        }
+    }
+}
+
+void Clinic::createRecurrence() {
+    ensureLoaded();
+
+    Date date (0, 0, CurrentYear);
+    modifyDate(date);
+
+    if (!date.valid()) {
+        clearScreen();
+        std::wcout << ErrorColor << L"Error: Select a day and month for the first visit\n" << getCol();
+        getCharV();
+        return;
+    }
+
+    u16 start = Appointment::DefaultStart, duration = Appointment::DefaultDuration;
+    modifyTime(start, duration);
+
+    const std::pair<std::shared_ptr<User>, u32> doctor = pickUser(false, date, start, duration);
+    if (!doctor.first) return;
+
+    clearScreen();
+    std::wcout << L"Repeat (w)eekly or (m)onthly? ";
+    const Frequency frequency = getChar() == 'm' ? Frequency::Monthly : Frequency::Weekly;
+
+    u32 interval = 0, count = 0;
+
+    std::wcout << L"\n\nRepeat every how many " << (frequency == Frequency::Weekly ? L"weeks" : L"months") << L" (between 1-" << MaximumInterval << L"): ";
+    std::cin >> interval;
+    clearInputBuffer();
+
+    if (!(interval > 0 && interval <= MaximumInterval)) {
+        std::wcout << ErrorColor << L"Invalid interval, it must be between 1 and " << MaximumInterval << getCol();
+        getCharV();
+        return;
+    }
+
+    std::wcout << L"Number of visits (between 2-" << MaximumVisits << L"): ";
+    std::cin >> count;
+    clearInputBuffer();
+
+    if (!(count >= 2 && count <= MaximumVisits)) {
+        std::wcout << ErrorColor << L"Invalid number of visits, it must be between 2 and " << MaximumVisits << getCol();
+        getCharV();
+        return;
+    }
+
+    const std::shared_ptr<Recurrence> recurrence = std::make_shared<Recurrence>(Appointment(date, doctor.second, CurrentIdx, start, duration), frequency, interval, count);
+
+    for (u16 i=0; i < count; ++i) {
+        const Appointment occurrence = recurrence->Occurrence(i);
+
+        if (!doctorIndex.IsFree(occurrence.doctorIdx, occurrence.date, occurrence.start, occurrence.duration)) {
+            std::wcout << ErrorColor << doctor.first->name << L" is already booked on " << occurrence.date.str() << L' ' << occurrence.timeStr() << getCol();
+            getCharV();
+            return;
+        }
+    }
+
+    recurrences.push_back(recurrence);
+    doctorIndex.AddSeries(*recurrence);
+    Metrics::Instance().Increment(Counter::AppointmentsCreated);
+
+    Event event (EventType::RecurrenceCreated, recurrence->first);
+    event.frequency = frequency;
+    event.interval = interval;
+    event.count = count;
+    record(event);
+    saveData();
+}
+
+void Clinic::moveOccurrence(Recurrence& recurrence, const u16 idx) {
+    const auto exception = recurrence.exceptions.find(idx);
+    const bool hadException = exception != recurrence.exceptions.end();
+    const std::shared_ptr<Appointment> previous = hadException ? exception->second : nullptr;
+    const Appointment occurrence = previous ? *previous : recurrence.Occurrence(idx);
+
+    if (previous) doctorIndex.Release(*previous);
+    recurrence.exceptions[idx] = nullptr;
+
+    Date date = occurrence.date;
+    modifyDate(date);
+
+    u16 start = occurrence.start;
+
+    if (!pickSlot(occurrence.doctorIdx, date, occurrence.duration, start, nullptr)) {
+        if (!hadException) recurrence.exceptions.erase(idx);
+        else if (previous) recurrence.exceptions[idx] = previous, doctorIndex.Book(*previous);
+        return;
+    }
+
+    const std::shared_ptr<Appointment> moved = std::make_shared<Appointment>(date, occurrence.doctorIdx, occurrence.patientIdx, start, occurrence.duration);
+    recurrence.exceptions[idx] = moved;
+    doctorIndex.Book(*moved);
+
+    Event event (EventType::OccurrenceMoved, recurrence.first);
+    event.occurrence = idx;
+    event.target = *moved;
+    record(event);
+
+    offerSlot(occurrence);
+    saveData();
+}
+
+void Clinic::occurrenceMenu(Recurrence& recurrence) {
+    u16 idx = 0;
+
+    while (true) {
+        clearScreen();
+
+        const u16 page = idx / OccurrencePage * OccurrencePage;
+        const u16 last = std::min<u32>(recurrence.count, page + OccurrencePage);
+
+        std::wcout << recurrence.ruleStr() << L"\n(a/d to change page, b to move, y to cancel a visit)\n\n";
+
+        for (u16 i = page; i < last; ++i) {
+            const auto exception = recurrence.exceptions.find(i);
+            const bool changed = exception != recurrence.exceptions.end();
+            const Appointment occurrence = changed && exception->second ? *exception->second : recurrence.Occurrence(i);
+
+            std::wcout << (idx == i ? SelectedColor : UnselectedColor)
+                << i + 1 << L") " << occurrence.date.str() << L' ' << occurrence.timeStr()
+                << (!changed ? L"" : exception->second ? L" (moved)" : L" (cancelled)")
+                << L'\n' << getCol();
+        }
+
+        switch (getChar()) {
+            case 'w': idx = idx == 0 ? recurrence.count - 1 : idx - 1; break;
+            case 's': idx = idx == recurrence.count - 1 ? 0 : idx + 1; break;
+            case 'a': idx = idx < OccurrencePage ? 0 : idx - OccurrencePage; break;
+            case 'd': idx = std::min<u32>(recurrence.count - 1, idx + OccurrencePage); break;
+
+            case 'b':
+            moveOccurrence(recurrence, idx);
+            break;
+
+            case 'y': {
+            const auto previous = recurrence.exceptions.find(idx);
+            if (previous != recurrence.exceptions.end() && !previous->second) break;
+
+            const Appointment freed = previous != recurrence.exceptions.end() ? *previous->second : recurrence.Occurrence(idx);
+            std::shared_ptr<Appointment>& exception = recurrence.exceptions[idx];
+            if (exception) doctorIndex.Release(*exception);
+
+            exception = nullptr;
+            Metrics::Instance().Increment(Counter::AppointmentsDeleted);
+
+            Event event (EventType::OccurrenceCancelled, recurrence.first);
+            event.occurrence = idx;
+            record(event);
+
+            offerSlot(freed);
+            saveData();
+            } break;
+
+            case 'q': return;
+
+            default: break;
+        }
+    }
+}
+
+void Clinic::recurrenceMenu(const bool isDoctor) {
+    ensureLoaded();
+    u32 idx = 0;
+
+    while (true) {
+        clearScreen();
+
+        std::vector<std::shared_ptr<Recurrence>> series;
+        for (const std::shared_ptr<Recurrence>& recurrence : recurrences)
+            if ((isDoctor ? recurrence->first.doctorIdx : recurrence->first.patientIdx) == CurrentIdx)
+                series.push_back(recurrence);
+
+        const u32 sz = series.size();
+        std::wcout << L"Recurring Visits\n\n";
+
+        if (sz == 0) std::wcout << SelectedColor << L"No recurring visits, " << (isDoctor ? L"" : L"press n to plan some, ") << L"press q to go back\n" << getCol();
+        if (idx >= sz) idx = 0;
+
+        for (u32 i=0; i < sz; ++i)
+            std::wcout << (idx == i ? SelectedColor : UnselectedColor)
+                << i + 1 << L") " << (isDoctor ? L"Patient: " : L"Doctor: ") << (isDoctor ? patients[series[i]->first.patientIdx].name : doctors[series[i]->first.doctorIdx].name)
+                << L'\n' << series[i]->ruleStr()
+                << L"\n\n" << getCol();
+
+        const char c = getChar();
+
+        if (c == 'q') return;
+
+        if (c == 'n') {
+            if (!isDoctor) createRecurrence();
+            continue;
+        }
+
+        if (sz == 0) continue;
+
+        switch (c) {
+            case 'w': case 'a': idx = idx == 0 ? sz - 1 : idx - 1; break;
+            case 's': case 'd': idx = idx == sz - 1 ? 0 : idx + 1; break;
+
+            case 'y':
+            doctorIndex.RemoveSeries(*series[idx]);
+            recurrences.erase(std::find(recurrences.begin(), recurrences.end(), series[idx]));
+            Metrics::Instance().Increment(Counter::AppointmentsDeleted);
+            record(Event(EventType::RecurrenceRemoved, series[idx]->first));
+            saveData();
+            break;
+
+            default:
+            occurrenceMenu(*series[idx]);
+            break;
+        }
+    }
 }
 
 void Clinic::mainServiceMenu(const bool isDoctor) {
     u8 idx = 0;
+    u32 booked = 0;
 
     while (true) {
         clearScreen();
@@ -196,11 +757,24 @@ void Clinic::mainServiceMenu(const bool isDoctor) {
 
         std::wcout << (isDoctor ? L"Doctor" : L"Patient") << " Actions\n\n";
 
+        if (!isDoctor) {
+            const u32 seen = booked;
+
+            for (const u32 id : waitlist.PatientEntries(CurrentIdx))
+                if (waitlist.Entries()[id].status == WaitStatus::Booked) waitlist.Notify(id), ++booked;
+
+            if (booked != seen) serializer.SaveWaitlist(waitlist);
+            if (booked) std::wcout << SelectedColor << booked << L" slot(s) booked from the waitlist, press l to view\n\n" << getCol();
+        }
+
         if (sz == 0) {
-            std::wcout << SelectedColor << "No appointments made yet, " << (isDoctor ? L"" : L"press n to make one or ") << L"press q to quit" << L'\n' << getCol();
+            std::wcout << SelectedColor << "No appointments made yet, " << (isDoctor ? L"" : L"press n to make one, ") << L"press h for history, r for recurring visits" << (isDoctor ? L"" : L", l for the waitlist") << L" or q to quit" << L'\n' << getCol();
             const char c = getChar();
 
             if (!isDoctor && c == 'n') createAppointment();
+            if (!isDoctor && c == 'l') waitlistMenu();
+            if (c == 'h') showHistory(isDoctor);
+            if (c == 'r') recurrenceMenu(isDoctor);
             if (c == 'q') return;
 
             continue;
@@ -210,9 +784,9 @@ void Clinic::mainServiceMenu(const bool isDoctor) {
             std::shared_ptr<Appointment> appointment = CurrentAppointments[i];
 
             std::wcout << (idx == i ? SelectedColor : UnselectedColor)
-                << i + 1 << L") " << (isDoctor ? L"Patient:" : L"Doctor: ") << (isDoctor ? patients[appointments[i]->patientIdx].name : doctors[appointments[i]->doctorIdx].name)
-                << L"\nDate: " << appointment->date.str()
-                << (!isDoctor ? L"\nSpecialization: " + getTypeWstr(doctors[appointments[i]->doctorIdx].type) : L"")
+                << i + 1 << L") " << (isDoctor ? L"Patient:" : L"Doctor: ") << (isDoctor ? patients[appointment->patientIdx].name : doctors[appointment->doctorIdx].name)
+                << L"\nDate: " << appointment->date.str() << L' ' << appointment->timeStr()
+                << (!isDoctor ? L"\nSpecialization: " + getTypeWstr(doctors[appointment->doctorIdx].type) : L"")
                 << L"\n\n" << getCol();
         }
 
@@ -242,20 +816,62 @@ void Clinic::mainServiceMenu(const bool isDoctor) {
             saveData();
             break;
 
-            case 'b':
-            modifyDate(CurrentAppointments[idx]->date);
+            case 'b': {
+            ensureLoaded();
+            const std::shared_ptr<Appointment> appointment = CurrentAppointments[idx];
+
+            Date date = appointment->date;
+            modifyDate(date);
+
+            u16 start = appointment->start;
+            if (!pickSlot(appointment->doctorIdx, date, appointment->duration, start, appointment.get())) break;
+
+            Event event (EventType::AppointmentMoved, *appointment);
+            const Appointment freed = *appointment;
+
+            doctorIndex.Release(*appointment);
+            appointment->date = date;
+            appointment->start = start;
+            doctorIndex.Book(*appointment);
+
+            event.target = *appointment;
+            record(event);
+            offerSlot(freed);
             saveData();
-            break;
+            } break;
 
             case 'v':
+            ensureLoaded();
             if (std::shared_ptr<User> user = pickUser(isDoctor).first) {
+                Event event (isDoctor ? EventType::PatientReplaced : EventType::DoctorReplaced);
+                event.userIdx = isDoctor ? CurrentAppointments[idx]->patientIdx : CurrentAppointments[idx]->doctorIdx;
+                event.name = user->name;
+                event.userType = user->type;
+
                 if (isDoctor) patients[CurrentAppointments[idx]->patientIdx] = *user;
-                else doctors[CurrentAppointments[idx]->doctorIdx] = *user;
+                else {
+                    doctors[CurrentAppointments[idx]->doctorIdx] = *user;
+                    doctorIndex.UpdateDoctor(CurrentAppointments[idx]->doctorIdx, user->type);
+                }
+
+                record(event);
 
                 saveData();
             }
             break;
 
+            case 'h':
+            showHistory(isDoctor);
+            break;
+
+            case 'r':
+            recurrenceMenu(isDoctor);
+            break;
+
+            case 'l':
+            if (!isDoctor) waitlistMenu();
+            break;
+
             case 'g': 
 			std::wcout << SelectedColor << L"Data saved successfully!\n" << getCol();
             getCharV();
@@ -267,6 +883,7 @@ void Clinic::mainServiceMenu(const bool isDoctor) {
             case 'y':
             deleteAppointment(idx);
             if (idx == sz - 1) --idx;
+            saveData();
             break;
 
             default: break;
@@ -275,6 +892,8 @@ void Clinic::mainServiceMenu(const bool isDoctor) {
 }
 
 std::pair<std::shared_ptr<User>, u32> Clinic::isValidName(const std::wstring& name) const {
+    const ScopedTimer timer (Timer::IsValidName);
+
     const auto doctor = std::find_if(doctors.begin(), doctors.end(), [&name](const User& doctor) {
         return doctor.name == name;
         });
@@ -301,46 +920,21 @@ bool Clinic::showPasswordError(const bool condition, const std::wstring& errorMe
     return true;
 }
 
-void Clinic::execPatientMenu(const bool hasAccount) {
-    std::wstring name;
+bool Clinic::Enter(const bool hasAccount, const std::wstring& name) {
+    if (hasAccount) {
+        const std::pair<std::shared_ptr<User>, u32> result = isValidName(name);
+        if (result.first == nullptr) return false;
 
-    while (true) {
-        clearScreen();
-        std::wcout << (hasAccount ? L"Log In" : L"Register") << L"\n\nEnter a username ("
-            << MinimumUsernameLength << L'-' << MaximumUsernameLength
-            << L" characters): ";
+        CurrentUser = result.first;
+        CurrentIdx = result.second;
 
-        std::string temp;
-        std::cin >> temp;
-        name = stw(temp);
-        clearInputBuffer();
-
-        if (const u32 sz = name.length(); !(sz >= MinimumUsernameLength && sz <= MaximumUsernameLength)) {
-            std::wcout << ErrorColor << L"\nInvalid username length " << getCol() << L"(Must be between "
-                << MinimumUsernameLength << L'-' << MaximumUsernameLength
-                << L" characters)" << getCol();
-            getCharV();
-        }
-        else if (!hasAccount && std::find_if(patients.begin(), patients.end(), [&name](const User& patient) {
-            return patient.name == name;
-            }) != patients.end()) {
-            std::wcout << ErrorColor << L"\nUsername already exists\n" << getCol();
-            getCharV();
-        }
-        else if (hasAccount) {
-            std::pair<std::shared_ptr<User>, u32> result = isValidName(name);
-
-            if (result.first == nullptr) {
-                std::wcout << ErrorColor << L"\nThere is nobody with that username" << getCol();
-                getCharV();
-                continue;
-            }
+        if (!fullyLoaded) {
+            const bool isDoctor = CurrentUser->type != Type::Patient;
+            User& user = (isDoctor ? doctors : patients)[CurrentIdx];
 
-            CurrentUser = result.first;
-            CurrentIdx = result.second;
-            break;
+            user = serializer.LoadUser(isDoctor, CurrentIdx);
+            CurrentUser = std::make_shared<User>(user);
         }
-        else break;
     }
 
     std::string password;
@@ -354,6 +948,7 @@ void Clinic::execPatientMenu(const bool hasAccount) {
             << L" characters): ";
 
         std::cin >> password;
+        if (!std::cin) return false;
         clearInputBuffer();
 
         if (const u32 sz = password.length(); !(sz >= MinimumPasswordLength && sz <= MaximumPasswordLength)) {
@@ -389,60 +984,168 @@ void Clinic::execPatientMenu(const bool hasAccount) {
     }
 
     if (!hasAccount) {
+        ensureLoaded();
         patients.emplace_back(name, password);
         CurrentUser = std::make_shared<User>(patients.back());
         CurrentIdx = patients.size() - 1;
+
+        Event event (EventType::PatientRegistered);
+        event.userIdx = CurrentIdx;
+        event.name = name;
+        record(event);
+        saveData();
+
         fetchAppointments(false);
     }
     else fetchAppointments(CurrentUser->type != Type::Patient);
 
     mainServiceMenu(CurrentUser->type != Type::Patient);
+    return true;
 }
 
-Clinic::Clinic(const std::string& saveFile) : serializer(saveFile) {
-    if (fs::is_regular_file(saveFile)) serializer.LoadData(doctors, patients, appointments);
-    else initializeData(), saveData();
+Clinic::Clinic(const std::string& saveFile) : serializer(saveFile), journal(saveFile) {
+    if (!fs::is_regular_file(saveFile)) initializeData(), saveData();
+    else if (serializer.LoadDirectory(doctors, patients)) fullyLoaded = false, doctorIndex.Build(doctors, appointments, recurrences);
+    else loadData();
+
+    serializer.LoadWaitlist(waitlist);
+    recoverArchives();
 }
 
-void Clinic::MainMenu() {
-    u8 idx = 0;
-    bool running = true;
+bool Clinic::HasUser(const std::wstring& name) const {
+    return isValidName(name).first != nullptr;
+}
 
-    while (running) {
-        clearScreen();
+std::vector<std::wstring> Clinic::UserNames() const {
+    std::vector<std::wstring> names;
+    names.reserve(doctors.size() + patients.size());
 
-        std::wcout << L"--- Clinic System ---\n\n"
-            << L"Do you have an existing account?"
-            << (idx == 0 ? SelectedColor : UnselectedColor) << L"\n1) Yes\n"
-            << (idx == 1 ? SelectedColor : UnselectedColor) << L"2) No\n"
-            << getCol();
+    for (const User& doctor : doctors) names.push_back(doctor.name);
+    for (const User& patient : patients) names.push_back(patient.name);
 
-        const char c = getChar();
+    return names;
+}
 
-        if (std::isdigit(c)) {
-            const u8 digit = c - '0';
+std::vector<OpenSlots> Clinic::FreeSlots(const Type type, const Date& date, const u16 duration) {
+    ensureLoaded();
 
-            if (digit < 1 || digit > 2) {
-                clearScreen();
-                std::wcout << ErrorColor << L"Error: Digit input must be between 1-2\n" << getCol();
-                getCharV();
-            }
-            else execPatientMenu(digit == 1);
+    std::vector<OpenSlots> open;
 
-            break;
-        }
+    for (const u32 doctorIdx : doctorIndex.Doctors(type)) {
+        std::vector<u16> starts = doctorIndex.FreeSlots(doctorIdx, date, OpeningTime, ClosingTime, SlotStep, duration);
+        if (!starts.empty()) open.push_back(OpenSlots { doctors[doctorIdx].name, std::move(starts) });
+    }
 
-        switch (c) {
-        case 'w': case 's':
-        case 'a': case 'd':
-            idx = idx == 0 ? 1 : 0; break;
+    return open;
+}
 
-        case 'q': running = false; break;
+u32 Clinic::Compact() {
+    ensureLoaded();
 
-        default:
-            execPatientMenu(idx == 0);
-            running = false;
-            break;
-        }
+    const u32 cutoff = Date::today().year;
+    std::map<u32, std::vector<std::shared_ptr<Appointment>>> finished;
+    std::vector<std::shared_ptr<Appointment>> current;
+    current.reserve(appointments.size());
+
+    for (const std::shared_ptr<Appointment>& appointment : appointments)
+        if (appointment->date.year < cutoff) finished[appointment->date.year].push_back(appointment);
+        else current.push_back(appointment);
+
+    const u32 moved = appointments.size() - current.size();
+    if (moved == 0) return 0;
+
+    for (auto& [year, yearAppointments] : finished) {
+        if (archive.find(year) == archive.end()) serializer.LoadArchive(year, archive[year]);
+
+        std::vector<std::shared_ptr<Appointment>>& segment = archive[year];
+        segment.insert(segment.end(), yearAppointments.begin(), yearAppointments.end());
+        serializer.SaveArchive(year, segment);
     }
+
+    appointments = std::move(current);
+    doctorIndex.Build(doctors, appointments, recurrences);
+
+    Event event (EventType::Compacted);
+    event.year = cutoff;
+    record(event);
+
+    saveData();
+    for (const auto& [year, yearAppointments] : finished) serializer.CommitArchive(year);
+
+    return moved;
+}
+
+void Clinic::Snapshot(const std::string& file) {
+    ensureLoaded();
+    serializer.SaveSnapshot(file, doctors, patients, appointments, recurrences);
+}
+
+void Clinic::PrintReport(const Date& from, const Date& to, const bool csv) {
+    ensureLoaded();
+
+    Report report (doctors, from, to);
+    report.Add(appointments);
+    report.AddSeries(recurrences);
+
+    for (const u32 year : serializer.ArchiveYears()) {
+        if (year < from.year || year > to.year) continue;
+        if (archive.find(year) == archive.end()) serializer.LoadArchive(year, archive[year]);
+
+        report.Add(archive[year]);
+    }
+
+    report.Finish();
+
+    if (csv) report.PrintCsv(std::wcout);
+    else report.PrintTable(std::wcout);
+}
+
+bool Clinic::Audit(const std::wstring& doctor, const Date& date, const u64 time) {
+    const ScopedTimer timer (Timer::Audit);
+
+    AuditState state;
+    if (!journal.Reconstruct(time, state)) {
+        const u64 first = journal.FirstTime();
+
+        if (first && first <= time) std::wcout << L"The history snapshot for that time is damaged\n";
+        else std::wcout << L"No history recorded before "
+                   << (first ? Date::fromDays(first / 86400).str() + L' ' + Appointment::timeStr(first % 86400 / 60) : L"the first change") << L'\n';
+        return false;
+    }
+
+    std::vector<Appointment> bookings;
+    u32 skipped = 0;
+
+    const auto matches = [&state, &doctor, &skipped](const Appointment& appointment) {
+        if (appointment.doctorIdx < state.doctors.size() && appointment.patientIdx < state.patients.size())
+            return state.doctors[appointment.doctorIdx].name == doctor;
+
+        ++skipped;
+        return false;
+    };
+
+    for (const std::shared_ptr<Appointment>& appointment : state.appointments)
+        if (appointment && appointment->date.key() == date.key() && matches(*appointment))
+            bookings.push_back(*appointment);
+
+    for (const std::shared_ptr<Recurrence>& recurrence : state.recurrences)
+        if (matches(recurrence->first))
+            for (const Appointment& occurrence : recurrence->Expand(date.days(), date.days()))
+                bookings.push_back(occurrence);
+
+    std::sort(bookings.begin(), bookings.end(), [](const Appointment& a, const Appointment& b) {
+        return a.begin() < b.begin();
+        });
+
+    std::wcout << L"Bookings with " << doctor << L" on " << date.str() << L" as of "
+               << Date::fromDays(time / 86400).str() << L' ' << Appointment::timeStr(time % 86400 / 60) << L" UTC\n\n";
+
+    if (bookings.empty()) std::wcout << L"No bookings\n";
+
+    for (const Appointment& booking : bookings)
+        std::wcout << booking.timeStr() << L"  " << state.patients[booking.patientIdx].name << L'\n';
+
+    if (skipped) std::wcout << ErrorColor << L'\n' << skipped << L" record(s) skipped, they reference users missing from the history" << getCol() << L'\n';
+
+    return true;
 }
\ No newline at end of file
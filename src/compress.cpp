@@ -0,0 +1,118 @@
+#include "compress.h"
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+static const u32 HashBits = 14;
+static const u32 MinMatch = 4;
+static const u32 MaxOffset = 0xFFFF;
+
+static void writeLength(std::string& out, u64 length) {
+    while (length >= 0xFF) {
+        out.push_back(static_cast<char>(0xFF));
+        length -= 0xFF;
+    }
+
+    out.push_back(static_cast<char>(length));
+}
+
+static u64 readLength(const std::string& in, u64& pos, u64 length) {
+    if (length != 0xF) return length;
+
+    while (pos < in.size()) {
+        const u8 byte = in[pos++];
+        length += byte;
+        if (byte != 0xFF) break;
+    }
+
+    return length;
+}
+
+static void writeSequence(std::string& out, const char* literals, const u64 literalCount, const u32 offset, const u64 matchLength) {
+    const u64 extra = matchLength ? matchLength - MinMatch : 0;
+
+    out.push_back(static_cast<char>((std::min<u64>(literalCount, 0xF) << 4) | std::min<u64>(extra, 0xF)));
+    if (literalCount >= 0xF) writeLength(out, literalCount - 0xF);
+
+    out.append(literals, literalCount);
+    if (!matchLength) return;
+
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (extra >= 0xF) writeLength(out, extra - 0xF);
+}
+
+std::string Compress(const std::string& in) {
+    const u64 sz = in.size();
+    const char* data = in.data();
+
+    std::string out;
+    out.reserve(sz / 2 + 16);
+
+    std::vector<u32> table (1 << HashBits, 0);
+    u64 anchor = 0, i = 0;
+
+    while (i + MinMatch <= sz) {
+        u32 sequence;
+        std::memcpy(&sequence, data + i, sizeof(u32));
+
+        const u32 hash = (sequence * 2654435761u) >> (32 - HashBits);
+        const u64 candidate = table[hash];
+        table[hash] = static_cast<u32>(i + 1);
+
+        if (candidate == 0 || i + 1 - candidate > MaxOffset || std::memcmp(data + candidate - 1, data + i, MinMatch) != 0) {
+            ++i;
+            continue;
+        }
+
+        const u64 ref = candidate - 1;
+        u64 length = MinMatch;
+        while (i + length < sz && data[ref + length] == data[i + length]) ++length;
+
+        writeSequence(out, data + anchor, i - anchor, static_cast<u32>(i - ref), length);
+        i += length;
+        anchor = i;
+    }
+
+    writeSequence(out, data + anchor, sz - anchor, 0, 0);
+    return out;
+}
+
+bool Decompress(const std::string& in, const u64 rawSize, std::string& out) {
+    out.clear();
+    out.reserve(std::min<u64>(rawSize, in.size() * MaximumExpansion));
+
+    u64 pos = 0;
+
+    while (pos < in.size()) {
+        const u8 token = in[pos++];
+
+        const u64 literalCount = readLength(in, pos, token >> 4);
+        if (pos + literalCount > in.size() || out.size() + literalCount > rawSize) return false;
+
+        out.append(in, pos, literalCount);
+        pos += literalCount;
+
+        if (pos == in.size()) break;
+        if (pos + 2 > in.size()) return false;
+
+        const u32 offset = static_cast<u8>(in[pos]) | static_cast<u8>(in[pos + 1]) << 8;
+        pos += 2;
+
+        const u64 matchLength = readLength(in, pos, token & 0xF) + MinMatch;
+        if (offset == 0 || offset > out.size() || out.size() + matchLength > rawSize) return false;
+
+        const u64 start = out.size() - offset;
+        for (u64 j = 0; j < matchLength; ++j) out.push_back(out[start + j]);
+    }
+
+    return out.size() == rawSize;
+}
+
+u32 Checksum(const std::string& in) {
+    u32 hash = 2166136261u;
+
+    for (const char c : in) hash = (hash ^ static_cast<u8>(c)) * 16777619u;
+
+    return hash;
+}
\ No newline at end of file
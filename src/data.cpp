@@ -1,4 +1,6 @@
 #include "data.h"
+#include <algorithm>
+#include <chrono>
 
 Date::Date(const u8 day, const u8 month, const u32 year) : day(day), month(month), year(year) {}
 Date::Date() : day(0), month(0), year(0) {}
@@ -11,6 +13,55 @@ std::wstring Date::str() const {
     return wss.str();
 }
 
+u32 Date::key() const {
+    return year * 10000 + month * 100 + day;
+}
+
+bool Date::valid() const {
+    return day >= 1 && day <= 31 && month >= 1 && month <= 12;
+}
+
+i32 Date::days() const {
+    const i32 y = static_cast<i32>(year) - (month <= 2);
+    const i32 era = (y >= 0 ? y : y - 399) / 400;
+    const i32 yoe = y - era * 400;
+    const i32 doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const i32 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+u8 Date::weekday() const {
+    return static_cast<u8>(((days() % 7) + 10) % 7);
+}
+
+Date Date::fromDays(const i32 days) {
+    const i32 z = days + 719468;
+    const i32 era = (z >= 0 ? z : z - 146096) / 146097;
+    const i32 doe = z - era * 146097;
+    const i32 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const i32 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const i32 mp = (5 * doy + 2) / 153;
+    const i32 month = mp < 10 ? mp + 3 : mp - 9;
+
+    return Date(doy - (153 * mp + 2) / 5 + 1, month, yoe + era * 400 + (month <= 2));
+}
+
+Date Date::today() {
+    return fromDays(std::chrono::duration_cast<std::chrono::hours>(std::chrono::system_clock::now().time_since_epoch()).count() / 24);
+}
+
+bool Date::parse(const std::string& str, Date& date) {
+    u32 day, month, year;
+    char a, b;
+
+    std::istringstream iss (str);
+    if (!(iss >> day >> a >> month >> b >> year) || a != '.' || b != '.' || day > 31 || month > 12) return false;
+
+    date = Date(day, month, year);
+    return date.valid();
+}
+
 Date& Date::operator=(const Date& other) {
     day = other.day;
     month = other.month;
@@ -25,7 +76,103 @@ bool Date::operator==(const Date& other) {
 User::User(const std::wstring& name, const std::string& password, const Type type) 
 : name(name), password(password), type(type) {}
 
-Appointment::Appointment(const Date date, const u32 doctorIdx, const u32 patientIdx)
-: date(date), doctorIdx(doctorIdx), patientIdx(patientIdx) {}
+User::User() : type(Type::Patient) {}
+
+Appointment::Appointment(const Date date, const u32 doctorIdx, const u32 patientIdx, const u16 start, const u16 duration)
+: date(date), doctorIdx(doctorIdx), patientIdx(patientIdx), start(start), duration(duration) {}
+
+Appointment::Appointment() : date(), patientIdx(0), doctorIdx(0), start(DefaultStart), duration(DefaultDuration) {}
+
+i64 Appointment::begin() const {
+    return static_cast<i64>(date.days()) * MinutesPerDay + start;
+}
+
+i64 Appointment::end() const {
+    return begin() + duration;
+}
+
+std::wstring Appointment::timeStr(const u16 minutes) {
+    std::wstringstream wss;
+    wss << (minutes / 60 < 10 ? L"0" : L"") << minutes / 60 << L':' << (minutes % 60 < 10 ? L"0" : L"") << minutes % 60;
+    return wss.str();
+}
+
+std::wstring Appointment::timeStr() const {
+    return timeStr(start) + L'-' + timeStr(start + duration);
+}
+
+Recurrence::Recurrence(const Appointment& first, const Frequency frequency, const u8 interval, const u16 count)
+: first(first), frequency(frequency), interval(interval), count(count) {}
+
+Recurrence::Recurrence() : frequency(Frequency::Weekly), interval(1), count(0) {}
+
+Appointment Recurrence::Occurrence(const u16 idx) const {
+    Date date;
+
+    if (frequency == Frequency::Weekly) date = Date::fromDays(first.date.days() + 7 * interval * idx);
+    else {
+        const u32 months = first.date.month - 1 + static_cast<u32>(interval) * idx;
+        const u32 year = first.date.year + months / 12;
+        const u8 month = months % 12 + 1;
+        const u8 last = Date::fromDays(Date(1, month % 12 + 1, year + (month == 12)).days() - 1).day;
+
+        date = Date(std::min(first.date.day, last), month, year);
+    }
+
+    return Appointment(date, first.doctorIdx, first.patientIdx, first.start, first.duration);
+}
+
+u16 Recurrence::LowerIndex(const i32 day) const {
+    const i32 origin = first.date.days();
+    if (day <= origin) return 0;
+
+    if (frequency == Frequency::Weekly) {
+        const i32 step = 7 * interval;
+        return std::min<i32>(count, (day - origin + step - 1) / step);
+    }
+
+    const Date date = Date::fromDays(day);
+    const i32 months = (static_cast<i32>(date.year) - static_cast<i32>(first.date.year)) * 12 + date.month - first.date.month;
+
+    u16 idx = std::min<i32>(count, std::max(0, months / interval - 1));
+    while (idx < count && Occurrence(idx).date.days() < day) ++idx;
+
+    return idx;
+}
+
+bool Recurrence::OccursOn(const i32 day, Appointment& occurrence) const {
+    const u16 idx = LowerIndex(day);
+    if (idx >= count || exceptions.find(idx) != exceptions.end()) return false;
+
+    occurrence = Occurrence(idx);
+    return occurrence.date.days() == day;
+}
+
+std::vector<Appointment> Recurrence::Expand(const i32 from, const i32 to) const {
+    std::vector<Appointment> occurrences;
+
+    for (u16 idx = LowerIndex(from); idx < count; ++idx) {
+        const Appointment occurrence = Occurrence(idx);
+        if (occurrence.date.days() > to) break;
+
+        if (exceptions.find(idx) == exceptions.end()) occurrences.push_back(occurrence);
+    }
 
-Appointment::Appointment() : date() {}
\ No newline at end of file
+    for (const auto& [idx, moved] : exceptions)
+        if (moved && moved->date.days() >= from && moved->date.days() <= to) occurrences.push_back(*moved);
+
+    std::sort(occurrences.begin(), occurrences.end(), [](const Appointment& a, const Appointment& b) {
+        return a.begin() < b.begin();
+        });
+
+    return occurrences;
+}
+
+std::wstring Recurrence::ruleStr() const {
+    std::wstringstream wss;
+    wss << L"Every " << interval << (frequency == Frequency::Weekly ? L" week(s)" : L" month(s)")
+        << L" from " << first.date.str() << L' ' << first.timeStr() << L", " << count << L" visit(s)";
+
+    if (!exceptions.empty()) wss << L" (" << exceptions.size() << L" changed)";
+    return wss.str();
+}
\ No newline at end of file
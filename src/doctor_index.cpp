@@ -0,0 +1,182 @@
+#include "doctor_index.h"
+#include <algorithm>
+
+bool DoctorIndex::isSpecialization(const Type type) {
+    return static_cast<u32>(type) < SpecializationCount;
+}
+
+void DoctorIndex::ensureDoctor(const u32 doctorIdx) {
+    if (doctorIdx < calendars.size()) return;
+
+    calendars.resize(doctorIdx + 1);
+    longest.resize(doctorIdx + 1, 0);
+    series.resize(doctorIdx + 1);
+}
+
+bool DoctorIndex::overlaps(const u32 doctorIdx, const i64 begin, const i64 end, const Appointment* ignore) const {
+    if (begin >= end || doctorIdx >= calendars.size()) return false;
+
+    const Calendar& calendar = calendars[doctorIdx];
+
+    for (auto it = calendar.lower_bound(begin - longest[doctorIdx]); it != calendar.end() && it->first < end; ++it)
+        if (it->second.first > begin && it->second.second != ignore) return true;
+
+    Appointment occurrence;
+
+    for (const Recurrence* recurrence : series[doctorIdx])
+        for (i64 day = begin / Appointment::MinutesPerDay; day <= (end - 1) / Appointment::MinutesPerDay; ++day)
+            if (recurrence->OccursOn(day, occurrence) && occurrence.begin() < end && occurrence.end() > begin) return true;
+
+    return false;
+}
+
+void DoctorIndex::Build(const std::vector<User>& doctors, const std::vector<std::shared_ptr<Appointment>>& appointments, const std::vector<std::shared_ptr<Recurrence>>& recurrences) {
+    for (std::vector<u32>& partition : partitions) partition.clear();
+    positions.clear();
+    calendars.clear();
+    longest.clear();
+    series.clear();
+
+    const u32 sz = doctors.size();
+    positions.reserve(sz);
+
+    for (u32 i=0; i < sz; ++i) AddDoctor(i, doctors[i].type);
+
+    for (const std::shared_ptr<Appointment>& appointment : appointments) Book(*appointment);
+    for (const std::shared_ptr<Recurrence>& recurrence : recurrences) AddSeries(*recurrence);
+}
+
+void DoctorIndex::AddDoctor(const u32 doctorIdx, const Type type) {
+    if (doctorIdx >= positions.size()) positions.resize(doctorIdx + 1, std::make_pair(Type::Patient, 0));
+    ensureDoctor(doctorIdx);
+    if (!isSpecialization(type)) return;
+
+    std::vector<u32>& partition = partitions[static_cast<u32>(type)];
+    positions[doctorIdx] = std::make_pair(type, partition.size());
+    partition.push_back(doctorIdx);
+}
+
+void DoctorIndex::UpdateDoctor(const u32 doctorIdx, const Type type) {
+    if (doctorIdx >= positions.size()) return AddDoctor(doctorIdx, type);
+
+    const auto [oldType, pos] = positions[doctorIdx];
+    if (oldType == type) return;
+
+    if (isSpecialization(oldType)) {
+        std::vector<u32>& partition = partitions[static_cast<u32>(oldType)];
+
+        partition[pos] = partition.back();
+        positions[partition[pos]].second = pos;
+        partition.pop_back();
+    }
+
+    positions[doctorIdx] = std::make_pair(Type::Patient, 0);
+    AddDoctor(doctorIdx, type);
+}
+
+void DoctorIndex::Book(const Appointment& appointment) {
+    const u32 doctorIdx = appointment.doctorIdx;
+    ensureDoctor(doctorIdx);
+
+    calendars[doctorIdx].emplace(appointment.begin(), std::make_pair(appointment.end(), &appointment));
+    longest[doctorIdx] = std::max(longest[doctorIdx], appointment.duration);
+}
+
+void DoctorIndex::Release(const Appointment& appointment) {
+    if (appointment.doctorIdx >= calendars.size()) return;
+
+    Calendar& calendar = calendars[appointment.doctorIdx];
+    const auto [first, last] = calendar.equal_range(appointment.begin());
+
+    for (auto it = first; it != last; ++it)
+        if (it->second.second == &appointment) {
+            calendar.erase(it);
+            return;
+        }
+}
+
+void DoctorIndex::AddSeries(const Recurrence& recurrence) {
+    ensureDoctor(recurrence.first.doctorIdx);
+    series[recurrence.first.doctorIdx].push_back(&recurrence);
+
+    for (const auto& [idx, moved] : recurrence.exceptions)
+        if (moved) Book(*moved);
+}
+
+void DoctorIndex::RemoveSeries(const Recurrence& recurrence) {
+    if (recurrence.first.doctorIdx >= series.size()) return;
+
+    std::vector<const Recurrence*>& doctorSeries = series[recurrence.first.doctorIdx];
+    doctorSeries.erase(std::remove(doctorSeries.begin(), doctorSeries.end(), &recurrence), doctorSeries.end());
+
+    for (const auto& [idx, moved] : recurrence.exceptions)
+        if (moved) Release(*moved);
+}
+
+const std::vector<u32>& DoctorIndex::Doctors(const Type type) const {
+    static const std::vector<u32> None;
+    return isSpecialization(type) ? partitions[static_cast<u32>(type)] : None;
+}
+
+bool DoctorIndex::IsFree(const u32 doctorIdx, const Date& date, const u16 start, const u16 duration, const Appointment* ignore) const {
+    const i64 begin = static_cast<i64>(date.days()) * Appointment::MinutesPerDay + start;
+    return !overlaps(doctorIdx, begin, begin + duration, ignore);
+}
+
+std::vector<u32> DoctorIndex::FreeDoctors(const Type type, const Date& date, const u16 start, const u16 duration) const {
+    std::vector<u32> freeDoctors;
+
+    for (const u32 doctorIdx : Doctors(type))
+        if (IsFree(doctorIdx, date, start, duration))
+            freeDoctors.push_back(doctorIdx);
+
+    return freeDoctors;
+}
+
+std::vector<u32> DoctorIndex::FreeDoctors(const Date& date, const u16 start, const u16 duration) const {
+    std::vector<u32> freeDoctors;
+
+    for (u32 t=0; t < SpecializationCount; ++t) {
+        const std::vector<u32> partition = FreeDoctors(static_cast<Type>(t), date, start, duration);
+        freeDoctors.insert(freeDoctors.end(), partition.begin(), partition.end());
+    }
+
+    std::sort(freeDoctors.begin(), freeDoctors.end());
+    return freeDoctors;
+}
+
+std::vector<u16> DoctorIndex::FreeSlots(const u32 doctorIdx, const Date& date, const u16 open, const u16 close, const u16 step, const u16 duration, const Appointment* ignore) const {
+    const i64 day = static_cast<i64>(date.days()) * Appointment::MinutesPerDay;
+    std::vector<std::pair<i64, i64>> busy;
+
+    if (doctorIdx < calendars.size()) {
+        const Calendar& calendar = calendars[doctorIdx];
+
+        for (auto it = calendar.lower_bound(day + open - longest[doctorIdx]); it != calendar.end() && it->first < day + close; ++it)
+            if (it->second.second != ignore && it->second.first > day + open) busy.emplace_back(it->first, it->second.first);
+
+        Appointment occurrence;
+
+        for (const Recurrence* recurrence : series[doctorIdx])
+            if (recurrence->OccursOn(date.days(), occurrence)) busy.emplace_back(occurrence.begin(), occurrence.end());
+    }
+
+    std::sort(busy.begin(), busy.end());
+    u32 merged = 0;
+
+    for (u32 i = 1; i < busy.size(); ++i)
+        if (busy[i].first <= busy[merged].second) busy[merged].second = std::max(busy[merged].second, busy[i].second);
+        else busy[++merged] = busy[i];
+
+    if (!busy.empty()) busy.resize(merged + 1);
+
+    std::vector<u16> slots;
+    u32 idx = 0;
+
+    for (u32 start = open; start + duration <= close; start += step) {
+        while (idx < busy.size() && busy[idx].second <= day + start) ++idx;
+        if (idx == busy.size() || busy[idx].first >= day + start + duration) slots.push_back(start);
+    }
+
+    return slots;
+}
\ No newline at end of file
@@ -0,0 +1,368 @@
+#include "journal.h"
+#include <algorithm>
+#include <chrono>
+
+static const u64 HeaderSize = 2 * sizeof(u32);
+
+static u64 now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static u32 magnitude(u64 n) {
+    u32 bits = 0;
+    while (n >>= 1) ++bits;
+
+    return bits;
+}
+
+static bool same(const Appointment& a, const Appointment& b) {
+    return a.date.key() == b.date.key() && a.doctorIdx == b.doctorIdx && a.patientIdx == b.patientIdx
+        && a.start == b.start && a.duration == b.duration;
+}
+
+Event::Event(const EventType type, const Appointment& appointment) : type(type), appointment(appointment) {}
+
+u64 AuditState::key(const Appointment& appointment) {
+    return static_cast<u64>(appointment.begin()) * 31 + appointment.doctorIdx;
+}
+
+u32 AuditState::find(const Appointment& appointment) {
+    if (!indexed) {
+        positions.reserve(appointments.size());
+        for (u32 i=0; i < appointments.size(); ++i)
+            if (appointments[i]) positions.emplace(key(*appointments[i]), i);
+
+        indexed = true;
+    }
+
+    const auto [first, last] = positions.equal_range(key(appointment));
+
+    for (auto it = first; it != last; ++it)
+        if (appointments[it->second] && same(*appointments[it->second], appointment)) {
+            const u32 position = it->second;
+            positions.erase(it);
+            return position;
+        }
+
+    return Journal::None;
+}
+
+std::vector<std::shared_ptr<Recurrence>>::iterator AuditState::findRecurrence(const Appointment& first) {
+    return std::find_if(recurrences.begin(), recurrences.end(), [&first](const std::shared_ptr<Recurrence>& recurrence) {
+        return same(recurrence->first, first);
+        });
+}
+
+void AuditState::Apply(const Event& event) {
+    switch (event.type) {
+        case EventType::AppointmentCreated:
+        appointments.push_back(std::make_shared<Appointment>(event.appointment));
+        if (indexed) positions.emplace(key(event.appointment), appointments.size() - 1);
+        break;
+
+        case EventType::AppointmentDeleted:
+        if (const u32 position = find(event.appointment); position != Journal::None) appointments[position] = nullptr;
+        break;
+
+        case EventType::AppointmentMoved:
+        if (const u32 position = find(event.appointment); position != Journal::None) {
+            appointments[position] = std::make_shared<Appointment>(event.target);
+            positions.emplace(key(event.target), position);
+        }
+        break;
+
+        case EventType::DoctorReplaced:
+        if (event.userIdx < doctors.size()) doctors[event.userIdx] = User(event.name, "", event.userType);
+        break;
+
+        case EventType::PatientReplaced:
+        if (event.userIdx < patients.size()) patients[event.userIdx] = User(event.name, "");
+        break;
+
+        case EventType::PatientRegistered:
+        patients.emplace_back(event.name, "");
+        break;
+
+        case EventType::RecurrenceCreated:
+        recurrences.push_back(std::make_shared<Recurrence>(event.appointment, event.frequency, event.interval, event.count));
+        break;
+
+        case EventType::RecurrenceRemoved:
+        if (const auto it = findRecurrence(event.appointment); it != recurrences.end()) recurrences.erase(it);
+        break;
+
+        case EventType::OccurrenceCancelled:
+        if (const auto it = findRecurrence(event.appointment); it != recurrences.end()) (*it)->exceptions[event.occurrence] = nullptr;
+        break;
+
+        case EventType::OccurrenceMoved:
+        if (const auto it = findRecurrence(event.appointment); it != recurrences.end())
+            (*it)->exceptions[event.occurrence] = std::make_shared<Appointment>(event.target);
+        break;
+
+        case EventType::Compacted:
+        for (std::shared_ptr<Appointment>& appointment : appointments)
+            if (appointment && appointment->date.year < event.year) appointment = nullptr;
+        break;
+    }
+}
+
+Journal::Journal(const std::string& saveFile)
+: EventsFile(saveFile + ".events"), CheckpointsFile(saveFile + ".checkpoints"), SnapshotPrefix(saveFile + ".snap.") {}
+
+void Journal::open() {
+    if (opened) return;
+    opened = true;
+
+    std::ifstream is(CheckpointsFile, std::ios::binary);
+
+    if (is && readBF<u32>(is) == Magic && readBF<u32>(is) <= Version)
+        while (true) {
+            Checkpoint checkpoint;
+            checkpoint.sequence = readBF<u64>(is);
+            checkpoint.time = readBF<u64>(is);
+            checkpoint.offset = readBF<u64>(is);
+
+            if (!is) break;
+            checkpoints.push_back(checkpoint);
+        }
+
+    std::ifstream events(EventsFile, std::ios::binary);
+    if (!events || readBF<u32>(events) != Magic || readBF<u32>(events) > Version) return;
+
+    u64 offset = checkpoints.empty() ? HeaderSize : checkpoints.back().offset;
+    sequence = checkpoints.empty() ? 0 : checkpoints.back().sequence;
+    lastTime = checkpoints.empty() ? 0 : checkpoints.back().time;
+
+    events.seekg(offset);
+
+    while (events.peek() != std::ifstream::traits_type::eof()) {
+        const Event event = loadEvent(events);
+        if (!events) break;
+
+        ++sequence;
+        lastTime = event.time;
+        offset = events.tellg();
+    }
+
+    end = offset;
+}
+
+void Journal::saveEvent(std::ostream& os, const Event& event) const {
+    writeBF<u8>(os, static_cast<u8>(event.type));
+    writeBF<u64>(os, event.time);
+
+    switch (event.type) {
+        case EventType::AppointmentCreated: case EventType::AppointmentDeleted: case EventType::RecurrenceRemoved:
+        writeRecord(os, event.appointment);
+        break;
+
+        case EventType::AppointmentMoved:
+        writeRecord(os, event.appointment);
+        writeRecord(os, event.target);
+        break;
+
+        case EventType::DoctorReplaced: case EventType::PatientReplaced: case EventType::PatientRegistered:
+        writeBF<u32>(os, event.userIdx);
+        writeWstr(os, event.name);
+        writeBF<Type>(os, event.userType);
+        break;
+
+        case EventType::RecurrenceCreated:
+        writeRecord(os, event.appointment);
+        writeBF<u8>(os, static_cast<u8>(event.frequency));
+        writeBF<u8>(os, event.interval);
+        writeBF<u16>(os, event.count);
+        break;
+
+        case EventType::OccurrenceCancelled:
+        writeRecord(os, event.appointment);
+        writeBF<u16>(os, event.occurrence);
+        break;
+
+        case EventType::OccurrenceMoved:
+        writeRecord(os, event.appointment);
+        writeBF<u16>(os, event.occurrence);
+        writeRecord(os, event.target);
+        break;
+
+        case EventType::Compacted:
+        writeBF<u32>(os, event.year);
+        break;
+    }
+}
+
+Event Journal::loadEvent(std::istream& is) const {
+    Event event (static_cast<EventType>(readBF<u8>(is)));
+    event.time = readBF<u64>(is);
+
+    switch (event.type) {
+        case EventType::AppointmentCreated: case EventType::AppointmentDeleted: case EventType::RecurrenceRemoved:
+        readRecord(is, event.appointment);
+        break;
+
+        case EventType::AppointmentMoved:
+        readRecord(is, event.appointment);
+        readRecord(is, event.target);
+        break;
+
+        case EventType::DoctorReplaced: case EventType::PatientReplaced: case EventType::PatientRegistered:
+        event.userIdx = readBF<u32>(is);
+        event.name = readWstr(is);
+        event.userType = readBF<Type>(is);
+        break;
+
+        case EventType::RecurrenceCreated:
+        readRecord(is, event.appointment);
+        event.frequency = static_cast<Frequency>(readBF<u8>(is));
+        event.interval = readBF<u8>(is);
+        event.count = readBF<u16>(is);
+        break;
+
+        case EventType::OccurrenceCancelled:
+        readRecord(is, event.appointment);
+        event.occurrence = readBF<u16>(is);
+        break;
+
+        case EventType::OccurrenceMoved:
+        readRecord(is, event.appointment);
+        event.occurrence = readBF<u16>(is);
+        readRecord(is, event.target);
+        break;
+
+        case EventType::Compacted:
+        event.year = readBF<u32>(is);
+        break;
+
+        default:
+        is.setstate(std::ios::failbit);
+        break;
+    }
+
+    return event;
+}
+
+std::string Journal::snapshotFile(const u64 sequence) const {
+    return SnapshotPrefix + std::to_string(sequence);
+}
+
+void Journal::saveCheckpoint(std::ostream& os, const Checkpoint& checkpoint) const {
+    writeBF<u64>(os, checkpoint.sequence);
+    writeBF<u64>(os, checkpoint.time);
+    writeBF<u64>(os, checkpoint.offset);
+}
+
+void Journal::prune() {
+    // The newest checkpoints stay dense, older ones keep the oldest of every power-of-two age bucket,
+    // so the first checkpoint survives and every logged event stays replayable at a cost that grows with its age
+    const u64 latest = checkpoints.back().sequence;
+    std::vector<Checkpoint> kept;
+    u32 previous = None;
+
+    for (const Checkpoint& checkpoint : checkpoints) {
+        const u64 age = (latest - checkpoint.sequence) / SnapshotInterval;
+        const u32 bucket = magnitude(age);
+
+        if (age < DenseCheckpoints || bucket != previous) kept.push_back(checkpoint);
+        else fs::remove(snapshotFile(checkpoint.sequence));
+
+        previous = bucket;
+    }
+
+    if (kept.size() == checkpoints.size()) return;
+    checkpoints = std::move(kept);
+
+    const std::string temp = CheckpointsFile + ".tmp";
+    std::ofstream os(temp, std::ios::binary | std::ios::trunc);
+
+    writeBF<u32>(os, Magic);
+    writeBF<u32>(os, Version);
+    for (const Checkpoint& checkpoint : checkpoints) saveCheckpoint(os, checkpoint);
+
+    os.close();
+    fs::rename(temp, CheckpointsFile);
+}
+
+bool Journal::Append(Event event) {
+    open();
+    event.time = std::max(lastTime, now());
+
+    std::fstream os;
+
+    if (end == 0) {
+        os.open(EventsFile, std::ios::out | std::ios::binary | std::ios::trunc);
+        writeBF<u32>(os, Magic);
+        writeBF<u32>(os, Version);
+        end = HeaderSize;
+    }
+    else {
+        if (fs::file_size(EventsFile) > end) fs::resize_file(EventsFile, end);
+
+        os.open(EventsFile, std::ios::in | std::ios::out | std::ios::binary);
+        os.seekp(end);
+    }
+
+    saveEvent(os, event);
+    end = os.tellp();
+    os.close();
+
+    ++sequence;
+    lastTime = event.time;
+
+    return checkpoints.empty() || sequence - checkpoints.back().sequence >= SnapshotInterval;
+}
+
+std::string Journal::SnapshotFile() {
+    open();
+    return snapshotFile(sequence);
+}
+
+void Journal::AddCheckpoint() {
+    open();
+
+    const bool created = !fs::is_regular_file(CheckpointsFile);
+    std::ofstream os(CheckpointsFile, std::ios::binary | std::ios::app);
+
+    if (created) {
+        writeBF<u32>(os, Magic);
+        writeBF<u32>(os, Version);
+    }
+
+    checkpoints.push_back(Checkpoint { sequence, lastTime, end });
+    saveCheckpoint(os, checkpoints.back());
+
+    os.close();
+    prune();
+}
+
+bool Journal::Reconstruct(const u64 time, AuditState& state) {
+    open();
+
+    const auto next = std::upper_bound(checkpoints.begin(), checkpoints.end(), time, [](const u64 t, const Checkpoint& checkpoint) {
+        return t < checkpoint.time;
+        });
+
+    if (next == checkpoints.begin()) return false;
+    const Checkpoint& checkpoint = *std::prev(next);
+
+    DoctorIndex doctorIndex;
+    if (!Serializer(snapshotFile(checkpoint.sequence)).LoadData(state.doctors, state.patients, state.appointments, state.recurrences, doctorIndex))
+        return false;
+
+    std::ifstream is(EventsFile, std::ios::binary);
+    is.seekg(checkpoint.offset);
+
+    for (u64 i = checkpoint.sequence; i < sequence; ++i) {
+        const Event event = loadEvent(is);
+        if (!is || event.time > time) break;
+
+        state.Apply(event);
+    }
+
+    return true;
+}
+
+u64 Journal::FirstTime() {
+    open();
+    return checkpoints.empty() ? 0 : checkpoints.front().time;
+}
\ No newline at end of file
@@ -1,7 +1,9 @@
-#include "clinic.h"
+#include "router.h"
+#include "metrics.h"
 #include <cstdint>
 #include <vector>
 #include <algorithm>
+#include <cwctype>
 
 #ifndef _WIN32
 #include <locale>
@@ -13,8 +15,29 @@
 #endif
 
 static const std::string SaveFile = "data.dat";
+static const std::string SitesDir = "sites";
+static const std::string MetricsFile = "data.dat.prom";
+static const std::chrono::seconds MetricsInterval (10);
+static const std::vector<std::string> ShardCommands { "compact", "snapshot", "report", "audit" };
 
-i32 main() {
+static bool parseType(const std::string& name, Type& type) {
+    std::wstring wanted = stw(name);
+    std::transform(wanted.begin(), wanted.end(), wanted.begin(), ::towlower);
+
+    for (u32 t = 0; t < SpecializationCount; ++t) {
+        std::wstring candidate = getTypeWstr(static_cast<Type>(t));
+        std::transform(candidate.begin(), candidate.end(), candidate.begin(), ::towlower);
+
+        if (candidate == wanted) {
+            type = static_cast<Type>(t);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+i32 main(i32 argc, char** argv) {
     #ifndef _WIN32
     initTerminalStates();
     std::locale::global (std::locale(""));
@@ -25,10 +48,84 @@ i32 main() {
     }
     #endif
 
-	Clinic clinic (SaveFile);
+    if (argc > 1 && std::string(argv[1]) == "stats") {
+        if (fs::is_regular_file(MetricsFile)) std::wcout << stw(readFile(MetricsFile)) << std::flush;
+        else std::wcout << L"No metrics recorded yet" << std::endl;
+        return 0;
+    }
+
+    std::string site;
+    if (argc > 2 && std::string(argv[1]) == "--site") site = argv[2], argc -= 2, argv += 2;
+
+    {
+        Router router (SaveFile, SitesDir);
+
+        if (argc > 3 && std::string(argv[1]) == "free") {
+            Type type;
+            Date date;
+            u32 duration = Appointment::DefaultDuration;
+
+            if (argc > 4) std::istringstream(argv[4]) >> duration;
+
+            if (!parseType(argv[2], type) || !Date::parse(argv[3], date) || duration == 0 || duration >= Appointment::MinutesPerDay) {
+                std::wcerr << L"Usage: clinic free <specialization> <dd.mm.yyyy> [minutes]" << std::endl;
+                return 1;
+            }
+
+            router.PrintFreeSlots(type, date, duration);
+            return 0;
+        }
+
+        const u32 shard = router.Find(site);
+
+        if (argc > 1 && shard == Router::None && std::find(ShardCommands.begin(), ShardCommands.end(), argv[1]) != ShardCommands.end()) {
+            std::wcerr << L"Unknown site, pass --site <name> to choose one" << std::endl;
+            return 1;
+        }
+
+        if (argc > 1 && std::string(argv[1]) == "compact") {
+            std::wcout << L"Archived " << router.Shard(shard).Compact() << L" appointments from past years" << std::endl;
+            return 0;
+        }
+
+        if (argc > 2 && std::string(argv[1]) == "snapshot") {
+            router.Shard(shard).Snapshot(argv[2]);
+            std::wcout << L"Snapshot written to " << stw(argv[2]) << std::endl;
+            return 0;
+        }
+
+        if (argc > 3 && std::string(argv[1]) == "report") {
+            Date from, to;
+
+            if (!Date::parse(argv[2], from) || !Date::parse(argv[3], to) || from.days() > to.days()) {
+                std::wcerr << L"Usage: clinic report <dd.mm.yyyy> <dd.mm.yyyy> [--csv]" << std::endl;
+                return 1;
+            }
+
+            router.Shard(shard).PrintReport(from, to, argc > 4 && std::string(argv[4]) == "--csv");
+            return 0;
+        }
+
+        if (argc > 4 && std::string(argv[1]) == "audit") {
+            Date date, asOf;
+            u32 hour = 23, minute = 59;
+            char colon = ':';
+
+            if (argc > 5) std::istringstream(argv[5]) >> hour >> colon >> minute;
+
+            if (!Date::parse(argv[3], date) || !Date::parse(argv[4], asOf) || colon != ':' || hour > 23 || minute > 59) {
+                std::wcerr << L"Usage: clinic audit <doctor> <dd.mm.yyyy> <as of dd.mm.yyyy> [HH:MM]" << std::endl;
+                return 1;
+            }
+
+            const u64 time = static_cast<u64>(asOf.days()) * 86400 + hour * 3600 + minute * 60 + 59;
+            return router.Shard(shard).Audit(stw(argv[2]), date, time) ? 0 : 1;
+        }
+
+        MetricsExporter exporter (MetricsFile, MetricsInterval);
+        router.MainMenu();
+    }
 
-	clinic.MainMenu();
-    
     std::wcout << getCol(RGB{0,255,0}) << L"\n\nAll data saved successfully\nGoodbye!" << getCol() << std::endl;
     
 #ifndef _WIN32
@@ -0,0 +1,105 @@
+#include "metrics.h"
+
+const u64 Metrics::BucketBounds[BucketCount - 1] = {
+    10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000
+};
+
+static const char* CounterNames[] = {
+    "clinic_save_calls_total", "clinic_full_loads_total",
+    "clinic_appointments_created_total", "clinic_appointments_deleted_total",
+    "clinic_waitlist_bookings_total"
+};
+
+static const char* TimerNames[] = {
+    "clinic_load_data_seconds", "clinic_save_data_seconds", "clinic_load_directory_seconds",
+    "clinic_is_valid_name_seconds", "clinic_pick_user_seconds", "clinic_audit_seconds"
+};
+
+Metrics& Metrics::Instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::Increment(const Counter counter) {
+    counters[static_cast<u32>(counter)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::Observe(const Timer timer, const u64 micros) {
+    Histogram& histogram = histograms[static_cast<u32>(timer)];
+
+    u32 bucket = 0;
+    while (bucket < BucketCount - 1 && micros > BucketBounds[bucket]) ++bucket;
+
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.sum.fetch_add(micros, std::memory_order_relaxed);
+}
+
+std::string Metrics::Prometheus() const {
+    std::ostringstream os;
+    os.imbue(std::locale::classic());
+
+    for (u32 i=0; i < static_cast<u32>(Counter::Count); ++i)
+        os << "# TYPE " << CounterNames[i] << " counter\n"
+           << CounterNames[i] << ' ' << counters[i].load(std::memory_order_relaxed) << '\n';
+
+    for (u32 i=0; i < static_cast<u32>(Timer::Count); ++i) {
+        const Histogram& histogram = histograms[i];
+        os << "# TYPE " << TimerNames[i] << " histogram\n";
+
+        u64 cumulative = 0;
+
+        for (u32 bucket=0; bucket < BucketCount; ++bucket) {
+            cumulative += histogram.buckets[bucket].load(std::memory_order_relaxed);
+
+            os << TimerNames[i] << "_bucket{le=\"";
+            if (bucket < BucketCount - 1) os << BucketBounds[bucket] / 1e6;
+            else os << "+Inf";
+            os << "\"} " << cumulative << '\n';
+        }
+
+        os << TimerNames[i] << "_sum " << histogram.sum.load(std::memory_order_relaxed) / 1e6 << '\n'
+           << TimerNames[i] << "_count " << histogram.count.load(std::memory_order_relaxed) << '\n';
+    }
+
+    return os.str();
+}
+
+void Metrics::WritePrometheus(const std::string& file) const {
+    const std::string temp = file + ".tmp";
+
+    std::ofstream os(temp);
+    os << Prometheus();
+    os.close();
+
+    std::error_code error;
+    fs::rename(temp, file, error);
+}
+
+ScopedTimer::ScopedTimer(const Timer timer) : timer(timer), start(std::chrono::steady_clock::now()) {}
+
+ScopedTimer::~ScopedTimer() {
+    Metrics::Instance().Observe(timer, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+void MetricsExporter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!condition.wait_for(lock, Interval, [this] { return stopping; }))
+        Metrics::Instance().WritePrometheus(File);
+}
+
+MetricsExporter::MetricsExporter(const std::string& file, const std::chrono::seconds interval)
+: File(file), Interval(interval), worker(&MetricsExporter::run, this) {}
+
+MetricsExporter::~MetricsExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    condition.notify_all();
+    worker.join();
+
+    Metrics::Instance().WritePrometheus(File);
+}
\ No newline at end of file
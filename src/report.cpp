@@ -0,0 +1,195 @@
+#include "report.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <iomanip>
+
+static const u32 TopDays = 5;
+
+static const wchar_t* WeekdayNames[] = {
+    L"Monday", L"Tuesday", L"Wednesday", L"Thursday", L"Friday", L"Saturday", L"Sunday"
+};
+
+Report::Report(const std::vector<User>& doctors, const Date& from, const Date& to)
+: doctors(doctors), first(from.days()), last(std::max(from.days(), to.days())),
+  weekCount((last - first) / 7 + 1), totals(makePartial()) {}
+
+Report::Partial Report::makePartial() const {
+    Partial partial;
+    const u64 sz = doctors.size();
+
+    partial.weeks.resize(sz);
+    partial.weekdays.assign(sz * 7, 0);
+    partial.patients.resize(sz);
+
+    return partial;
+}
+
+void Report::aggregate(const std::vector<std::shared_ptr<Appointment>>& appointments, Partial& partial, const u64 begin, const u64 end) const {
+    const u32 sz = doctors.size();
+
+    for (u64 i = begin; i < end; ++i) {
+        const Appointment& appointment = *appointments[i];
+        if (appointment.doctorIdx >= sz || !appointment.date.valid()) continue;
+
+        const i32 days = appointment.date.days();
+        if (days < first || days > last) continue;
+
+        const u32 offset = days - first;
+        const u32 doctor = appointment.doctorIdx;
+
+        ++partial.weeks[doctor][offset / 7];
+        ++partial.weekdays[static_cast<u64>(doctor) * 7 + appointment.date.weekday()];
+        ++partial.days[offset];
+        partial.patients[doctor].push_back(appointment.patientIdx);
+    }
+
+    for (std::vector<u32>& patients : partial.patients) {
+        std::sort(patients.begin(), patients.end());
+        patients.erase(std::unique(patients.begin(), patients.end()), patients.end());
+    }
+}
+
+void Report::merge(Partial& partial) {
+    for (u64 i = 0; i < totals.weeks.size(); ++i)
+        for (const auto& [week, count] : partial.weeks[i]) totals.weeks[i][week] += count;
+
+    for (u64 i = 0; i < totals.weekdays.size(); ++i) totals.weekdays[i] += partial.weekdays[i];
+    for (const auto& [day, count] : partial.days) totals.days[day] += count;
+
+    for (u64 i = 0; i < totals.patients.size(); ++i) {
+        std::vector<u32> merged;
+        merged.reserve(totals.patients[i].size() + partial.patients[i].size());
+
+        std::set_union(totals.patients[i].begin(), totals.patients[i].end(),
+                       partial.patients[i].begin(), partial.patients[i].end(), std::back_inserter(merged));
+
+        totals.patients[i] = std::move(merged);
+    }
+}
+
+Report::Row Report::makeRow(const std::wstring& name, const Type type, const std::vector<u32>& members) const {
+    Row row { name, type, 0, 0, members.size(), 0, 0, 0 };
+
+    std::unordered_map<u32, u64> weeks;
+    std::array<u64, 7> weekdays {};
+    std::vector<u32> patients;
+
+    for (const u32 doctor : members) {
+        for (const auto& [week, count] : totals.weeks[doctor]) weeks[week] += count;
+        for (u32 d = 0; d < 7; ++d) weekdays[d] += totals.weekdays[static_cast<u64>(doctor) * 7 + d];
+
+        patients.insert(patients.end(), totals.patients[doctor].begin(), totals.patients[doctor].end());
+    }
+
+    std::sort(patients.begin(), patients.end());
+    patients.erase(std::unique(patients.begin(), patients.end()), patients.end());
+
+    for (const auto& [week, count] : weeks) {
+        row.appointments += count;
+        if (count > row.busiestWeekCount || (count == row.busiestWeekCount && week < row.busiestWeek)) row.busiestWeek = week, row.busiestWeekCount = count;
+    }
+
+    row.busiestWeekday = std::distance(weekdays.begin(), std::max_element(weekdays.begin(), weekdays.end()));
+    row.patients = patients.size();
+
+    return row;
+}
+
+double Report::perWeek(const Row& row) const {
+    return static_cast<double>(row.appointments) / weekCount;
+}
+
+void Report::Add(const std::vector<std::shared_ptr<Appointment>>& appointments) {
+    ThreadPool& pool = ThreadPool::Shared();
+    std::vector<Partial> partials (pool.ChunkCount(appointments.size(), AppointmentChunk));
+
+    pool.ParallelFor(appointments.size(), AppointmentChunk, [&](const u32 idx, const u64 begin, const u64 end) {
+        partials[idx] = makePartial();
+        aggregate(appointments, partials[idx], begin, end);
+        });
+
+    for (Partial& partial : partials) merge(partial);
+}
+
+void Report::AddSeries(const std::vector<std::shared_ptr<Recurrence>>& recurrences) {
+    std::vector<std::shared_ptr<Appointment>> occurrences;
+
+    for (const std::shared_ptr<Recurrence>& recurrence : recurrences)
+        for (const Appointment& occurrence : recurrence->Expand(first, last))
+            occurrences.push_back(std::make_shared<Appointment>(occurrence));
+
+    Add(occurrences);
+}
+
+void Report::Finish() {
+    const u32 sz = doctors.size();
+
+    doctorRows.clear();
+    doctorRows.reserve(sz);
+
+    for (u32 i = 0; i < sz; ++i) doctorRows.push_back(makeRow(doctors[i].name, doctors[i].type, {i}));
+
+    specializationRows.clear();
+
+    for (u32 t = 0; t < SpecializationCount; ++t) {
+        std::vector<u32> members;
+        for (u32 i = 0; i < sz; ++i)
+            if (static_cast<u32>(doctors[i].type) == t) members.push_back(i);
+
+        if (!members.empty()) specializationRows.push_back(makeRow(L"", static_cast<Type>(t), members));
+    }
+}
+
+void Report::PrintTable(std::wostream& os) const {
+    os << L"Utilization report " << Date::fromDays(first).str() << L" - " << Date::fromDays(last).str() << L"\n\n"
+       << std::left << std::setw(22) << L"Doctor" << std::setw(18) << L"Specialization"
+       << std::right << std::setw(8) << L"Appts" << std::setw(10) << L"Patients" << std::setw(10) << L"Per week"
+       << std::setw(14) << L"Busiest week" << std::setw(7) << L"Count" << L"  Busiest day\n";
+
+    const auto printRow = [&](const Row& row, const std::wstring& name) {
+        os << std::left << std::setw(22) << name << std::setw(18) << getTypeWstr(row.type)
+           << std::right << std::setw(8) << row.appointments << std::setw(10) << row.patients
+           << std::setw(10) << std::fixed << std::setprecision(2) << perWeek(row)
+           << std::setw(14) << Date::fromDays(first + row.busiestWeek * 7).str() << std::setw(7) << row.busiestWeekCount
+           << L"  " << (row.appointments ? WeekdayNames[row.busiestWeekday] : L"-") << L'\n';
+    };
+
+    for (const Row& row : doctorRows) printRow(row, row.name);
+
+    os << L"\nBy specialization\n";
+    for (const Row& row : specializationRows) printRow(row, std::to_wstring(row.doctors) + L" doctor(s)");
+
+    std::vector<std::pair<u32, u64>> busiestDays (totals.days.begin(), totals.days.end());
+
+    const u64 top = std::min<u64>(TopDays, busiestDays.size());
+    std::partial_sort(busiestDays.begin(), busiestDays.begin() + top, busiestDays.end(), [](const std::pair<u32, u64>& a, const std::pair<u32, u64>& b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+        });
+
+    os << L"\nBusiest days\n";
+    for (u64 i = 0; i < top; ++i)
+        os << Date::fromDays(first + busiestDays[i].first).str() << L"  " << busiestDays[i].second << L'\n';
+}
+
+void Report::PrintCsv(std::wostream& os) const {
+    const std::locale previous = os.imbue(std::locale::classic());
+    os << L"scope,name,specialization,doctors,appointments,patients,per_week,busiest_week_start,busiest_week_count,busiest_weekday\n";
+
+    const auto printRow = [&](const wchar_t* scope, const Row& row) {
+        os << scope << L',' << row.name << L',' << getTypeWstr(row.type) << L',' << row.doctors << L','
+           << row.appointments << L',' << row.patients << L',' << std::fixed << std::setprecision(2) << perWeek(row) << L','
+           << Date::fromDays(first + row.busiestWeek * 7).str() << L',' << row.busiestWeekCount << L','
+           << (row.appointments ? WeekdayNames[row.busiestWeekday] : L"") << L'\n';
+    };
+
+    for (const Row& row : doctorRows) printRow(L"doctor", row);
+    for (const Row& row : specializationRows) printRow(L"specialization", row);
+
+    std::vector<std::pair<u32, u64>> days (totals.days.begin(), totals.days.end());
+    std::sort(days.begin(), days.end());
+
+    for (const auto& [day, count] : days)
+        os << L"day," << Date::fromDays(first + day).str() << L",,," << count << L",,,,,\n";
+
+    os.imbue(previous);
+}
\ No newline at end of file
@@ -0,0 +1,335 @@
+#include "router.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <numeric>
+
+std::string Router::saveFile(const u32 idx) const {
+    return sites[idx].empty() ? SaveFile : (fs::path(SitesDir) / sites[idx] / fs::path(SaveFile).filename()).string();
+}
+
+std::wstring Router::siteName(const u32 idx) const {
+    return stw(sites[idx].empty() ? SaveFile : sites[idx]);
+}
+
+std::vector<std::string> Router::populatedSites() const {
+    std::vector<std::string> populated;
+
+    for (u32 i = 0; i < sites.size(); ++i)
+        if (fs::is_regular_file(saveFile(i))) populated.push_back(sites[i]);
+
+    return populated;
+}
+
+void Router::ensureRoutes() {
+    if (routed || sites.size() == 1) return;
+    routed = true;
+
+    std::ifstream is(RoutesFile, std::ios::binary);
+    bool current = is && readBF<u32>(is) == RoutesMagic && readBF<u32>(is) <= RoutesVersion;
+
+    if (current) {
+        std::vector<std::string> covered (readBF<u32>(is));
+        for (std::string& site : covered) site = readStr(is);
+
+        current = covered == populatedSites();
+    }
+
+    if (!current) {
+        is.close();
+        rebuildRoutes();
+        return;
+    }
+
+    const u32 sz = readBF<u32>(is);
+    routes.reserve(sz);
+
+    for (u32 i = 0; i < sz; ++i) {
+        Route route;
+        readRecord(is, route);
+
+        if (const u32 idx = Find(route.site); idx != None) routes.emplace(route.name, idx);
+    }
+
+    is.close();
+}
+
+void Router::saveRoutes() const {
+    std::ofstream os(RoutesFile, std::ios::binary);
+
+    writeBF<u32>(os, RoutesMagic);
+    writeBF<u32>(os, RoutesVersion);
+
+    const std::vector<std::string> populated = populatedSites();
+    writeBF<u32>(os, populated.size());
+    for (const std::string& site : populated) writeStr(os, site);
+
+    writeBF<u32>(os, routes.size());
+    for (const auto& [name, idx] : routes) writeRecord(os, Route { name, sites[idx] });
+
+    os.close();
+}
+
+void Router::rebuildRoutes() {
+    std::vector<std::vector<std::wstring>> names (sites.size());
+    std::vector<std::future<void>> tasks;
+
+    for (u32 i = 0; i < sites.size(); ++i)
+        tasks.push_back(std::async(std::launch::async, [this, &names, i] {
+            if (shards[i]) {
+                names[i] = shards[i]->UserNames();
+                return;
+            }
+
+            if (!fs::is_regular_file(saveFile(i))) return;
+
+            Serializer serializer (saveFile(i));
+            std::vector<User> doctors, patients;
+
+            if (!serializer.LoadDirectory(doctors, patients)) {
+                std::vector<std::shared_ptr<Appointment>> appointments;
+                std::vector<std::shared_ptr<Recurrence>> recurrences;
+                DoctorIndex doctorIndex;
+
+                doctors.clear(), patients.clear();
+                if (!serializer.LoadData(doctors, patients, appointments, recurrences, doctorIndex)) return;
+            }
+
+            for (const User& doctor : doctors) names[i].push_back(doctor.name);
+            for (const User& patient : patients) names[i].push_back(patient.name);
+            }));
+
+    ThreadPool::Wait(tasks);
+
+    routes.clear();
+    for (u32 i = 0; i < sites.size(); ++i)
+        for (const std::wstring& name : names[i]) routes.emplace(name, i);
+
+    rebuilt = true;
+    saveRoutes();
+}
+
+void Router::addRoute(const std::wstring& name, const u32 idx) {
+    if (sites.size() == 1) return;
+
+    ensureRoutes();
+    routes.emplace(name, idx);
+    saveRoutes();
+}
+
+std::vector<u32> Router::resolve(const std::wstring& name, const bool refresh) {
+    if (sites.size() == 1) return Shard(0).HasUser(name) ? std::vector<u32> { 0 } : std::vector<u32>();
+
+    ensureRoutes();
+    std::vector<u32> owners;
+    const auto [first, last] = routes.equal_range(name);
+
+    for (auto it = first; it != last; ++it)
+        if (Shard(it->second).HasUser(name)) owners.push_back(it->second);
+
+    if (owners.empty() && refresh && !rebuilt) {
+        rebuildRoutes();
+        return resolve(name, false);
+    }
+
+    std::sort(owners.begin(), owners.end());
+    return owners;
+}
+
+u32 Router::pickSite(const std::vector<u32>& candidates) const {
+    u8 idx = 0;
+    const u32 sz = candidates.size();
+
+    while (true) {
+        clearScreen();
+        std::wcout << L"Choose a site\n\n";
+
+        for (u32 i=0; i < sz; ++i)
+            std::wcout << (idx==i ? SelectedColor : UnselectedColor)
+                       << i + 1 << L") " << siteName(candidates[i])
+                       << L'\n' << getCol();
+
+        const char c = getChar();
+
+        if (c == 'q') return None;
+
+        if (std::isdigit(c)) {
+            const u8 digit = c - '0';
+
+            if (digit < 1 || digit > sz) {
+                clearScreen();
+                std::wcout << ErrorColor << L"Error: Digit input must be between 1-" << sz << L'\n' << getCol();
+                getCharV();
+                continue;
+            }
+
+            idx = digit - 1;
+            continue;
+        }
+
+        switch (c) {
+            case 'w': case 'a': idx = idx == 0 ? static_cast<u8>(sz - 1) : idx - 1; break;
+            case 's': case 'd': idx = idx == sz - 1 ? 0 : idx + 1; break;
+
+            default: return candidates[idx];
+        }
+    }
+}
+
+void Router::enter(const bool hasAccount) {
+    std::wstring name;
+    std::vector<u32> owners;
+
+    while (true) {
+        clearScreen();
+        std::wcout << (hasAccount ? L"Log In" : L"Register") << L"\n\nEnter a username ("
+            << MinimumUsernameLength << L'-' << MaximumUsernameLength
+            << L" characters): ";
+
+        std::string temp;
+        std::cin >> temp;
+        if (!std::cin) return;
+
+        name = stw(temp);
+        clearInputBuffer();
+
+        if (const u32 sz = name.length(); !(sz >= MinimumUsernameLength && sz <= MaximumUsernameLength)) {
+            std::wcout << ErrorColor << L"\nInvalid username length " << getCol() << L"(Must be between "
+                << MinimumUsernameLength << L'-' << MaximumUsernameLength
+                << L" characters)" << getCol();
+            getCharV();
+            continue;
+        }
+
+        owners = resolve(name, hasAccount);
+
+        if (!hasAccount && !owners.empty()) {
+            std::wcout << ErrorColor << L"\nUsername already exists\n" << getCol();
+            getCharV();
+        }
+        else if (hasAccount && owners.empty()) {
+            std::wcout << ErrorColor << L"\nThere is nobody with that username" << getCol();
+            getCharV();
+        }
+        else break;
+    }
+
+    if (!hasAccount) {
+        owners.resize(sites.size());
+        std::iota(owners.begin(), owners.end(), 0);
+    }
+
+    const u32 idx = owners.size() == 1 ? owners.front() : pickSite(owners);
+    if (idx == None) return;
+
+    if (Shard(idx).Enter(hasAccount, name) && !hasAccount) addRoute(name, idx);
+}
+
+Router::Router(const std::string& saveFile, const std::string& sitesDir)
+: SaveFile(saveFile), SitesDir(sitesDir), RoutesFile((fs::path(sitesDir) / "routes.dat").string()) {
+    if (fs::is_directory(SitesDir))
+        for (const fs::directory_entry& entry : fs::directory_iterator(SitesDir))
+            if (entry.is_directory()) sites.push_back(entry.path().filename().string());
+
+    std::sort(sites.begin(), sites.end());
+    if (sites.empty()) sites.emplace_back();
+
+    shards.resize(sites.size());
+
+    if (sites.size() == 1) Shard(0);
+}
+
+u32 Router::Find(const std::string& site) const {
+    if (site.empty() && sites.size() == 1) return 0;
+
+    const auto it = std::find(sites.begin(), sites.end(), site);
+    return it == sites.end() ? None : std::distance(sites.begin(), it);
+}
+
+Clinic& Router::Shard(const u32 idx) {
+    if (shards[idx]) return *shards[idx];
+
+    const bool created = !fs::is_regular_file(saveFile(idx));
+    shards[idx] = std::make_unique<Clinic>(saveFile(idx));
+
+    // Only menu flows load routes and they run on one thread, so this never races the fan-out
+    if (created && routed) {
+        for (const std::wstring& name : shards[idx]->UserNames()) routes.emplace(name, idx);
+        saveRoutes();
+    }
+
+    return *shards[idx];
+}
+
+std::vector<std::vector<OpenSlots>> Router::FreeSlots(const Type type, const Date& date, const u16 duration) {
+    std::vector<std::vector<OpenSlots>> results (sites.size());
+    std::vector<std::future<void>> tasks;
+
+    // Shard loads block on the shared pool themselves, so the fan-out runs on its own threads
+    // Sites without a save file are skipped, opening them would write the default clinic
+    for (u32 i = 0; i < sites.size(); ++i)
+        tasks.push_back(std::async(std::launch::async, [this, &results, type, &date, duration, i] {
+            if (shards[i] || fs::is_regular_file(saveFile(i))) results[i] = Shard(i).FreeSlots(type, date, duration);
+            }));
+
+    ThreadPool::Wait(tasks);
+    return results;
+}
+
+void Router::PrintFreeSlots(const Type type, const Date& date, const u16 duration) {
+    const std::vector<std::vector<OpenSlots>> results = FreeSlots(type, date, duration);
+    bool found = false;
+
+    std::wcout << L"Free " << getTypeWstr(type) << L" doctors on " << date.str() << L" for " << duration << L" minutes\n\n";
+
+    for (u32 i = 0; i < results.size(); ++i)
+        for (const OpenSlots& open : results[i]) {
+            std::wcout << siteName(i) << L"  " << open.doctor << L"  from " << Appointment::timeStr(open.starts.front())
+                       << L", " << open.starts.size() << L" free starts\n";
+            found = true;
+        }
+
+    if (!found) std::wcout << L"No free doctors\n";
+}
+
+void Router::MainMenu() {
+    u8 idx = 0;
+    bool running = true;
+
+    while (running) {
+        clearScreen();
+
+        std::wcout << L"--- Clinic System ---\n\n"
+            << L"Do you have an existing account?"
+            << (idx == 0 ? SelectedColor : UnselectedColor) << L"\n1) Yes\n"
+            << (idx == 1 ? SelectedColor : UnselectedColor) << L"2) No\n"
+            << getCol();
+
+        const char c = getChar();
+
+        if (std::isdigit(c)) {
+            const u8 digit = c - '0';
+
+            if (digit < 1 || digit > 2) {
+                clearScreen();
+                std::wcout << ErrorColor << L"Error: Digit input must be between 1-2\n" << getCol();
+                getCharV();
+            }
+            else enter(digit == 1);
+
+            break;
+        }
+
+        switch (c) {
+        case 'w': case 's':
+        case 'a': case 'd':
+            idx = idx == 0 ? 1 : 0; break;
+
+        case 'q': running = false; break;
+
+        default:
+            enter(idx == 0);
+            running = false;
+            break;
+        }
+    }
+}
\ No newline at end of file
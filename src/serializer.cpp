@@ -1,91 +1,731 @@
 #include "serializer.h"
+#include "compress.h"
+#include "thread_pool.h"
+#include "metrics.h"
+#include <algorithm>
+#include <unordered_map>
 
-void Serializer::saveDate(std::ofstream& os, const Date& date) const {
-    writeBF<u8>(os, date.day);
-    writeBF<u8>(os, date.month);
-    writeBF<u32>(os, date.year);
+using DatePacking = VarintPacking<Date>;
+
+void Serializer::saveUser(std::ostream& os, const User& user, const bool isDoctor) const {
+    isDoctor ? writeRecord<User, DoctorSchema>(os, user) : writeRecord<User, PatientSchema>(os, user);
+}
+
+User Serializer::loadUser(std::istream& is, const bool isDoctor) const {
+    User user;
+    isDoctor ? readRecord<User, DoctorSchema>(is, user) : readRecord<User, PatientSchema>(is, user);
+
+    return user;
 }
 
-void Serializer::savePatient(std::ofstream& os, const User& user) const {
-    writeWstr(os, user.name);
-    writeStr(os, user.password);
+std::string Serializer::packAppointments(const std::vector<std::shared_ptr<Appointment>>& appointments, const u64 begin, const u64 end) const {
+    std::string data ((end - begin) * AppointmentSize, '\0');
+    char* out = data.data();
+
+    for (u64 i = begin; i < end; ++i) out = packRecord(out, *appointments[i]);
+
+    return data;
 }
 
-void Serializer::saveDoctor(std::ofstream& os, const User& user) const {
-    writeWstr(os, user.name);
-    writeStr(os, user.password);
-    writeBF<Type>(os, user.type);
+void Serializer::unpackAppointments(const char* in, const bool timed, std::vector<std::shared_ptr<Appointment>>& appointments, const u64 begin, const u64 end) const {
+    for (u64 i = begin; i < end; ++i) {
+        std::shared_ptr<Appointment> appointment = std::make_shared<Appointment>();
+        in = timed ? unpackRecord(in, *appointment) : unpackRecord<Appointment, UntimedAppointmentSchema>(in, *appointment);
+        appointments[i] = appointment;
+    }
 }
 
-Date Serializer::loadDate(std::ifstream& is) const {
-    const u8 day = readBF<u8>(is);
-    const u8 month = readBF<u8>(is);
-    const u32 year = readBF<u32>(is);
+void Serializer::saveAppointments(std::ostream& os, const std::vector<std::shared_ptr<Appointment>>& appointments) const {
+    writeBF<u32>(os, ArchiveMagic);
+    writeBF<u32>(os, ArchiveVersion);
+    writeBF<u32>(os, appointments.size());
 
-    return Date(day, month, year);
+    const std::string data = packAppointments(appointments, 0, appointments.size());
+    os.write(data.data(), data.size());
 }
 
-User Serializer::loadDoctor(std::ifstream& is) const {
-    const std::wstring name = readWstr(is);
-    const std::string password = readStr(is);
-    const Type type = readBF<Type>(is);
+void Serializer::loadAppointments(std::istream& is, std::vector<std::shared_ptr<Appointment>>& appointments, const bool timed) const {
+    const u32 sz = readBF<u32>(is);
+    std::string data (static_cast<u64>(sz) * (timed ? AppointmentSize : UntimedAppointmentSize), '\0');
+    is.read(data.data(), data.size());
 
-    return User(name, password, type);
+    const u64 base = appointments.size();
+    appointments.resize(base + sz);
+    unpackAppointments(data.data(), timed, appointments, base, base + sz);
 }
 
-User Serializer::loadPatient(std::ifstream& is) const {
-    const std::wstring name = readWstr(is);
-    const std::string password = readStr(is);
+void Serializer::saveRecurrences(std::ostream& os, const std::vector<std::shared_ptr<Recurrence>>& recurrences) const {
+    writeBF<u32>(os, recurrences.size());
+
+    for (const std::shared_ptr<Recurrence>& recurrence : recurrences) {
+        writeRecord(os, *recurrence);
 
-    return User(name, password);
+        writeBF<u32>(os, recurrence->exceptions.size());
+        for (const auto& [idx, moved] : recurrence->exceptions) {
+            writeBF<u16>(os, idx);
+            writeBF<u8>(os, moved != nullptr);
+            if (moved) writeRecord(os, *moved);
+        }
+    }
 }
 
-void Serializer::loadAppointments(std::ifstream& is, std::vector<std::shared_ptr<Appointment>>& appointments) const {
+void Serializer::loadRecurrences(std::istream& is, std::vector<std::shared_ptr<Recurrence>>& recurrences, const bool movedRecords) const {
     const u32 sz = readBF<u32>(is);
-    appointments.reserve(sz);
+    recurrences.reserve(sz);
+
+    for (u32 i = 0; i < sz; ++i) {
+        std::shared_ptr<Recurrence> recurrence = std::make_shared<Recurrence>();
+        readRecord(is, *recurrence);
+        const Appointment& first = recurrence->first;
+
+        const u32 exceptions = readBF<u32>(is);
+        for (u32 j = 0; j < exceptions; ++j) {
+            const u16 idx = readBF<u16>(is);
+            std::shared_ptr<Appointment>& moved = recurrence->exceptions[idx];
+
+            if (!readBF<u8>(is)) continue;
+
+            moved = std::make_shared<Appointment>(first);
+
+            if (movedRecords) readRecord(is, *moved);
+            else {
+                readRecord(is, moved->date);
+                moved->start = readBF<u16>(is);
+            }
+        }
+
+        recurrences.push_back(recurrence);
+    }
+}
+
+std::string Serializer::archiveFile(const u32 year) const {
+    return SaveFile + '.' + std::to_string(year);
+}
+
+std::string Serializer::pendingFile(const u32 year) const {
+    return archiveFile(year) + ".pending";
+}
+
+std::vector<u32> Serializer::scanYears(const std::string& extension) const {
+    std::vector<u32> years;
+
+    const fs::path path (SaveFile);
+    const fs::path dir = path.has_parent_path() ? path.parent_path() : fs::path(".");
+    const std::string prefix = path.filename().string() + '.';
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(dir)) {
+        const std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file() || name.size() <= prefix.size() + extension.size() || name.compare(0, prefix.size(), prefix) != 0
+            || name.compare(name.size() - extension.size(), extension.size(), extension) != 0) continue;
+
+        const std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - extension.size());
+        if (digits.size() <= MaximumYearDigits && std::all_of(digits.begin(), digits.end(), [](const char c) { return std::isdigit(c); }))
+            years.push_back(std::stoul(digits));
+    }
+
+    std::sort(years.begin(), years.end());
+    return years;
+}
+
+std::string Serializer::waitlistFile() const {
+    return SaveFile + ".waitlist";
+}
+
+void Serializer::indexUsers(const std::vector<User>& users, const std::vector<std::shared_ptr<Appointment>>& appointments, const bool isDoctor,
+                            std::vector<DirectoryEntry>& entries, std::vector<u32>& lists) const {
+    const u32 sz = users.size();
+    std::unordered_map<std::wstring, u32> owners;
+    owners.reserve(sz);
+
+    for (u32 i = 0; i < sz; ++i) owners.emplace(users[i].name, i);
+
+    std::vector<u32> owner (sz);
+    for (u32 i = 0; i < sz; ++i) owner[i] = owners[users[i].name];
+
+    std::vector<std::vector<u32>> positions (sz);
+    const u32 asz = appointments.size();
+
+    for (u32 i = 0; i < asz; ++i) positions[owner[isDoctor ? appointments[i]->doctorIdx : appointments[i]->patientIdx]].push_back(i);
+
+    lists.reserve(asz);
 
     for (u32 i = 0; i < sz; ++i) {
-        const Date date = loadDate(is);
-        const u32 doctor = readBF<u32>(is);
-        const u32 patient = readBF<u32>(is);
+        entries[i].listStart = lists.size();
+        entries[i].listCount = positions[i].size();
+        lists.insert(lists.end(), positions[i].begin(), positions[i].end());
+    }
+}
+
+void Serializer::encodeUsers(const std::vector<User>& users, const bool isDoctor, Chunk& chunk, std::vector<DirectoryEntry>& entries) const {
+    std::ostringstream os;
+
+    for (u64 i = chunk.begin; i < chunk.end; ++i) {
+        entries[i].record = os.tellp();
+        saveUser(os, users[i], isDoctor);
+    }
+
+    chunk.data = os.str();
+}
+
+void Serializer::encodeAppointments(const std::vector<std::shared_ptr<Appointment>>& appointments, Chunk& chunk) const {
+    chunk.data = packAppointments(appointments, chunk.begin, chunk.end);
+}
+
+void Serializer::writeChunks(std::ostream& os, const std::vector<Chunk>& chunks, std::vector<DirectoryEntry>* entries) const {
+    for (const Chunk& chunk : chunks) {
+        const u64 base = os.tellp();
+
+        if (entries)
+            for (u64 i = chunk.begin; i < chunk.end; ++i) (*entries)[i].record += base;
+
+        os.write(chunk.data.data(), chunk.data.size());
+    }
+}
+
+void Serializer::decodeUsers(const std::string& data, std::vector<User>& users, const std::vector<DirectoryEntry>& entries, const bool isDoctor, const u64 begin, const u64 end) const {
+    if (begin == end) return;
+
+    MemoryBuffer buffer (data.data() + entries[begin].record, data.data() + data.size());
+    std::istream is (&buffer);
+
+    for (u64 i = begin; i < end; ++i) users[i] = loadUser(is, isDoctor);
+}
+
+void Serializer::decodeAppointments(const std::string& data, const u64 offset, const bool timed, std::vector<std::shared_ptr<Appointment>>& appointments, const u64 begin, const u64 end) const {
+    unpackAppointments(data.data() + offset + begin * (timed ? AppointmentSize : UntimedAppointmentSize), timed, appointments, begin, end);
+}
+
+void Serializer::saveDirectory(std::ostream& os, const std::vector<User>& users, const std::vector<DirectoryEntry>& entries, const bool isDoctor) const {
+    const u32 sz = users.size();
+    writeBF<u32>(os, sz);
+
+    for (u32 i = 0; i < sz; ++i) {
+        writeWstr(os, users[i].name);
+        if (isDoctor) writeBF<Type>(os, users[i].type);
+
+        writeBF<u64>(os, entries[i].record);
+        writeBF<u32>(os, entries[i].listStart);
+        writeBF<u32>(os, entries[i].listCount);
+    }
+}
+
+void Serializer::loadDirectory(std::istream& is, std::vector<User>& users, std::vector<DirectoryEntry>& entries, const bool isDoctor) const {
+    const u32 sz = readBF<u32>(is);
+    users.reserve(sz);
+    entries.resize(sz);
+
+    for (u32 i = 0; i < sz; ++i) {
+        const std::wstring name = readWstr(is);
+        users.emplace_back(name, "", isDoctor ? readBF<Type>(is) : Type::Patient);
+
+        entries[i].record = readBF<u64>(is);
+        entries[i].listStart = readBF<u32>(is);
+        entries[i].listCount = readBF<u32>(is);
+    }
+}
+
+std::string Serializer::packBlock(const std::string& raw) const {
+    const std::string compressed = Compress(raw);
+    std::ostringstream os;
+
+    writeVarint(os, raw.size());
+    writeVarint(os, compressed.size());
+    writeBF<u32>(os, Checksum(raw));
+    os.write(compressed.data(), compressed.size());
+
+    return os.str();
+}
+
+bool Serializer::readBlock(std::istream& is, const bool checked, Block& block) const {
+    block.rawSize = readVarint(is);
+    const u64 sz = readCount(is);
+    if (!is || block.rawSize > sz * MaximumExpansion) return false;
+
+    block.checksum = checked ? readBF<u32>(is) : 0;
+    block.compressed.resize(sz);
+    is.read(block.compressed.data(), sz);
+
+    return static_cast<bool>(is);
+}
+
+bool Serializer::unpackBlock(const Block& block, const bool checked, std::string& raw) const {
+    return Decompress(block.compressed, block.rawSize, raw) && (!checked || Checksum(raw) == block.checksum);
+}
+
+void Serializer::saveCompactUser(std::ostream& os, const User& user, const bool isDoctor) const {
+    isDoctor ? writeVarintRecord<User, DoctorSchema>(os, user) : writeVarintRecord<User, PatientSchema>(os, user);
+}
+
+bool Serializer::loadCompactUser(std::istream& is, const bool isDoctor, User& user) const {
+    isDoctor ? readVarintRecord<User, DoctorSchema>(is, user) : readVarintRecord<User, PatientSchema>(is, user);
+    return is && (!isDoctor || static_cast<u32>(user.type) < SpecializationCount);
+}
+
+std::string Serializer::encodeCompactUsers(const std::vector<User>& users, const bool isDoctor) const {
+    std::ostringstream os;
+
+    writeVarint(os, users.size());
+    for (const User& user : users) saveCompactUser(os, user, isDoctor);
+
+    return os.str();
+}
+
+std::string Serializer::encodeCompactAppointments(const std::vector<std::shared_ptr<Appointment>>& appointments) const {
+    std::vector<std::shared_ptr<Appointment>> sorted (appointments);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const std::shared_ptr<Appointment>& a, const std::shared_ptr<Appointment>& b) {
+        return std::make_pair(DatePacking::Pack(a->date), a->start) < std::make_pair(DatePacking::Pack(b->date), b->start);
+        });
+
+    std::ostringstream os;
+    writeVarint(os, sorted.size());
+    u64 previous = 0;
+
+    for (const std::shared_ptr<Appointment>& appointment : sorted) {
+        const u64 key = DatePacking::Pack(appointment->date);
+
+        writeVarint(os, key - previous);
+        writeVarintRecord<Appointment, TailSchema<Schema<Appointment>>>(os, *appointment);
+        previous = key;
+    }
+
+    return os.str();
+}
+
+std::string Serializer::encodeCompactRecurrences(const std::vector<std::shared_ptr<Recurrence>>& recurrences) const {
+    std::ostringstream os;
+    writeVarint(os, recurrences.size());
+
+    for (const std::shared_ptr<Recurrence>& recurrence : recurrences) {
+        writeVarintRecord(os, *recurrence);
+
+        writeVarint(os, recurrence->exceptions.size());
+        for (const auto& [idx, moved] : recurrence->exceptions) {
+            writeVarint(os, idx);
+            writeVarint(os, moved != nullptr);
+            if (moved) writeVarintRecord(os, *moved);
+        }
+    }
+
+    return os.str();
+}
+
+bool Serializer::decodeCompactUsers(const std::string& raw, std::vector<User>& users, const bool isDoctor) const {
+    MemoryBuffer buffer (raw.data(), raw.data() + raw.size());
+    std::istream is (&buffer);
+
+    users.resize(readCount(is));
+
+    for (User& user : users)
+        if (!loadCompactUser(is, isDoctor, user)) return false;
+
+    return static_cast<bool>(is);
+}
+
+bool Serializer::decodeCompactAppointments(const std::string& raw, std::vector<std::shared_ptr<Appointment>>& appointments, const bool timed) const {
+    MemoryBuffer buffer (raw.data(), raw.data() + raw.size());
+    std::istream is (&buffer);
+
+    const u64 sz = readCount(is);
+    appointments.reserve(sz);
+
+    u64 key = 0;
+
+    for (u64 i = 0; i < sz && is; ++i) {
+        std::shared_ptr<Appointment> appointment = std::make_shared<Appointment>();
+
+        key += readVarint(is);
+        appointment->date = DatePacking::Unpack(key);
+
+        if (timed) readVarintRecord<Appointment, TailSchema<Schema<Appointment>>>(is, *appointment);
+        else readVarintRecord<Appointment, TailSchema<UntimedAppointmentSchema>>(is, *appointment);
+
+        appointments.push_back(appointment);
+    }
+
+    return static_cast<bool>(is);
+}
+
+bool Serializer::decodeCompactRecurrences(const std::string& raw, std::vector<std::shared_ptr<Recurrence>>& recurrences, const bool movedRecords) const {
+    MemoryBuffer buffer (raw.data(), raw.data() + raw.size());
+    std::istream is (&buffer);
+
+    const u64 sz = readCount(is);
+    recurrences.reserve(sz);
+
+    for (u64 i = 0; i < sz; ++i) {
+        std::shared_ptr<Recurrence> recurrence = std::make_shared<Recurrence>();
+        readVarintRecord(is, *recurrence);
 
-        appointments.push_back(std::make_shared<Appointment>(date, doctor, patient));
+        if (!is || recurrence->frequency > Frequency::Monthly || recurrence->interval == 0) return false;
+
+        const u64 exceptions = readCount(is);
+        for (u64 j = 0; j < exceptions && is; ++j) {
+            std::shared_ptr<Appointment>& moved = recurrence->exceptions[readVarint(is)];
+
+            if (movedRecords) {
+                if (readVarint(is)) moved = std::make_shared<Appointment>(), readVarintRecord(is, *moved);
+            }
+            else if (const u64 key = readVarint(is)) {
+                moved = std::make_shared<Appointment>(recurrence->first);
+                moved->date = DatePacking::Unpack(key);
+                moved->start = readVarint(is);
+            }
+        }
+
+        recurrences.push_back(recurrence);
     }
+
+    return static_cast<bool>(is);
+}
+
+bool Serializer::loadSnapshot(std::istream& is, std::vector<User>& doctors, std::vector<User>& patients, std::vector<std::shared_ptr<Appointment>>& appointments, std::vector<std::shared_ptr<Recurrence>>& recurrences) const {
+    const u32 version = readBF<u32>(is);
+    if (!is || version > SnapshotVersion) return false;
+
+    const bool timed = version >= TimedSnapshotVersion;
+    const bool recurring = version >= RecurringSnapshotVersion;
+    const bool checked = version >= CheckedSnapshotVersion;
+    const bool movedRecords = version >= MovedRecordSnapshotVersion;
+
+    Block doctorsBlock, patientsBlock, appointmentsBlock, recurrencesBlock;
+    if (!readBlock(is, checked, doctorsBlock) || !readBlock(is, checked, patientsBlock) || !readBlock(is, checked, appointmentsBlock)
+        || (recurring && !readBlock(is, checked, recurrencesBlock))) return false;
+
+    ThreadPool& pool = ThreadPool::Shared();
+    std::vector<std::future<void>> tasks;
+    std::string doctorsRaw, patientsRaw, appointmentsRaw, recurrencesRaw;
+    bool doctorsValid, patientsValid, appointmentsValid, recurrencesValid = true;
+
+    tasks.push_back(pool.Submit([&] { doctorsValid = unpackBlock(doctorsBlock, checked, doctorsRaw); }));
+    tasks.push_back(pool.Submit([&] { patientsValid = unpackBlock(patientsBlock, checked, patientsRaw); }));
+    tasks.push_back(pool.Submit([&] { appointmentsValid = unpackBlock(appointmentsBlock, checked, appointmentsRaw); }));
+    if (recurring) tasks.push_back(pool.Submit([&] { recurrencesValid = unpackBlock(recurrencesBlock, checked, recurrencesRaw); }));
+
+    ThreadPool::Wait(tasks);
+    if (!doctorsValid || !patientsValid || !appointmentsValid || !recurrencesValid) return false;
+
+    tasks.clear();
+    tasks.push_back(pool.Submit([&] { doctorsValid = decodeCompactUsers(doctorsRaw, doctors, true); }));
+    tasks.push_back(pool.Submit([&] { patientsValid = decodeCompactUsers(patientsRaw, patients, false); }));
+    tasks.push_back(pool.Submit([&] { appointmentsValid = decodeCompactAppointments(appointmentsRaw, appointments, timed); }));
+    if (recurring && recurrencesBlock.rawSize) tasks.push_back(pool.Submit([&] { recurrencesValid = decodeCompactRecurrences(recurrencesRaw, recurrences, movedRecords); }));
+
+    ThreadPool::Wait(tasks);
+    if (!doctorsValid || !patientsValid || !appointmentsValid || !recurrencesValid) return false;
+
+    const auto owned = [&doctors, &patients](const Appointment& appointment) {
+        return appointment.doctorIdx < doctors.size() && appointment.patientIdx < patients.size();
+    };
+
+    return std::all_of(appointments.begin(), appointments.end(), [&owned](const std::shared_ptr<Appointment>& appointment) { return owned(*appointment); })
+        && std::all_of(recurrences.begin(), recurrences.end(), [&owned](const std::shared_ptr<Recurrence>& recurrence) {
+            return owned(recurrence->first) && std::all_of(recurrence->exceptions.begin(), recurrence->exceptions.end(), [&owned](const auto& exception) {
+                return !exception.second || owned(*exception.second);
+                });
+            });
 }
 
 Serializer::Serializer(const std::string& SaveFile) : SaveFile(SaveFile) {}
 
-void Serializer::SaveData(const std::vector<User>& doctors, const std::vector<User>& patients, const std::vector<std::shared_ptr<Appointment>>& appointments) const {
-    std::ofstream os(SaveFile, std::ios::binary);
+void Serializer::SaveData(const std::vector<User>& doctors, const std::vector<User>& patients, const std::vector<std::shared_ptr<Appointment>>& appointments, const std::vector<std::shared_ptr<Recurrence>>& recurrences) const {
+    const ScopedTimer timer (Timer::SaveData);
+
+    ThreadPool& pool = ThreadPool::Shared();
+
+    std::vector<DirectoryEntry> doctorDirectory (doctors.size()), patientDirectory (patients.size());
+    std::vector<u32> doctorLists, patientLists;
+
+    std::vector<Chunk> doctorChunks (pool.ChunkCount(doctors.size(), UserChunk));
+    std::vector<Chunk> patientChunks (pool.ChunkCount(patients.size(), UserChunk));
+    std::vector<Chunk> appointmentChunks (pool.ChunkCount(appointments.size(), AppointmentChunk));
+
+    std::vector<std::future<void>> tasks;
+    const auto enqueue = [&tasks](std::vector<std::future<void>>&& chunks) {
+        for (std::future<void>& chunk : chunks) tasks.push_back(std::move(chunk));
+    };
+
+    tasks.push_back(pool.Submit([&] { indexUsers(doctors, appointments, true, doctorDirectory, doctorLists); }));
+    tasks.push_back(pool.Submit([&] { indexUsers(patients, appointments, false, patientDirectory, patientLists); }));
+
+    enqueue(pool.SubmitChunks(doctors.size(), UserChunk, [&](const u32 idx, const u64 begin, const u64 end) {
+        doctorChunks[idx].begin = begin, doctorChunks[idx].end = end;
+        encodeUsers(doctors, true, doctorChunks[idx], doctorDirectory);
+        }));
+
+    enqueue(pool.SubmitChunks(patients.size(), UserChunk, [&](const u32 idx, const u64 begin, const u64 end) {
+        patientChunks[idx].begin = begin, patientChunks[idx].end = end;
+        encodeUsers(patients, false, patientChunks[idx], patientDirectory);
+        }));
+
+    enqueue(pool.SubmitChunks(appointments.size(), AppointmentChunk, [&](const u32 idx, const u64 begin, const u64 end) {
+        appointmentChunks[idx].begin = begin, appointmentChunks[idx].end = end;
+        encodeAppointments(appointments, appointmentChunks[idx]);
+        }));
+
+    ThreadPool::Wait(tasks);
+
+    for (DirectoryEntry& entry : patientDirectory) entry.listStart += doctorLists.size();
+
+    const std::string temp = SaveFile + ".tmp";
+    std::ofstream os(temp, std::ios::binary);
+
+    writeBF<u32>(os, Magic);
+    writeBF<u32>(os, Version);
+
+    const std::streampos offsetsPos = os.tellp();
+    writeBF<u64>(os, 0);
+    writeBF<u64>(os, 0);
+
+    saveDirectory(os, doctors, doctorDirectory, true);
+    saveDirectory(os, patients, patientDirectory, false);
+
+    const u64 listsPos = os.tellp();
+    writeBF<u32>(os, doctorLists.size() + patientLists.size());
+    for (const u32 position : doctorLists) writeBF<u32>(os, position);
+    for (const u32 position : patientLists) writeBF<u32>(os, position);
 
     writeBF<u32>(os, doctors.size());
-    for (const User& doctor : doctors) saveDoctor(os, doctor);
+    writeChunks(os, doctorChunks, &doctorDirectory);
 
     writeBF<u32>(os, patients.size());
-    for (const User& patient : patients) savePatient(os, patient);
+    writeChunks(os, patientChunks, &patientDirectory);
 
+    const u64 appointmentsPos = os.tellp();
     writeBF<u32>(os, appointments.size());
-    for (std::shared_ptr<Appointment> appointment : appointments)
-        saveDate(os, appointment->date),
-        writeBF<u32>(os, appointment->doctorIdx),
-        writeBF<u32>(os, appointment->patientIdx);
+    writeChunks(os, appointmentChunks, nullptr);
+
+    saveRecurrences(os, recurrences);
+
+    os.seekp(offsetsPos);
+    writeBF<u64>(os, listsPos);
+    writeBF<u64>(os, appointmentsPos);
+
+    saveDirectory(os, doctors, doctorDirectory, true);
+    saveDirectory(os, patients, patientDirectory, false);
 
     os.close();
+    fs::rename(temp, SaveFile);
+}
+
+bool Serializer::LoadData(std::vector<User>& doctors, std::vector<User>& patients, std::vector<std::shared_ptr<Appointment>>& appointments, std::vector<std::shared_ptr<Recurrence>>& recurrences, DoctorIndex& doctorIndex) const {
+    const ScopedTimer timer (Timer::LoadData);
+
+    const std::string data = readFile(SaveFile);
+    MemoryBuffer buffer (data.data(), data.data() + data.size());
+    std::istream is (&buffer);
+
+    const u32 magic = readBF<u32>(is);
+
+    if (magic == SnapshotMagic) {
+        if (!loadSnapshot(is, doctors, patients, appointments, recurrences)) return false;
+    }
+    else if (magic == Magic) {
+        const u32 version = readBF<u32>(is);
+        if (version > Version) return false;
+
+        const bool timed = version >= TimedVersion;
+        readBF<u64>(is);
+        const u64 appointmentsPos = readBF<u64>(is);
+
+        std::vector<DirectoryEntry> doctorDirectory, patientDirectory;
+        loadDirectory(is, doctors, doctorDirectory, true);
+        loadDirectory(is, patients, patientDirectory, false);
+
+        is.seekg(appointmentsPos);
+        appointments.resize(readBF<u32>(is));
+
+        ThreadPool& pool = ThreadPool::Shared();
+        std::vector<std::future<void>> tasks;
+        const auto enqueue = [&tasks](std::vector<std::future<void>>&& chunks) {
+            for (std::future<void>& chunk : chunks) tasks.push_back(std::move(chunk));
+        };
+
+        enqueue(pool.SubmitChunks(doctors.size(), UserChunk, [&](const u32, const u64 begin, const u64 end) {
+            decodeUsers(data, doctors, doctorDirectory, true, begin, end);
+            }));
+
+        enqueue(pool.SubmitChunks(patients.size(), UserChunk, [&](const u32, const u64 begin, const u64 end) {
+            decodeUsers(data, patients, patientDirectory, false, begin, end);
+            }));
+
+        enqueue(pool.SubmitChunks(appointments.size(), AppointmentChunk, [&](const u32, const u64 begin, const u64 end) {
+            decodeAppointments(data, appointmentsPos + sizeof(u32), timed, appointments, begin, end);
+            }));
+
+        ThreadPool::Wait(tasks);
+
+        if (version >= RecurringVersion) {
+            is.seekg(appointmentsPos + sizeof(u32) + appointments.size() * AppointmentSize);
+            loadRecurrences(is, recurrences, version >= MovedRecordVersion);
+        }
+    }
+    else {
+        is.seekg(0);
+
+        u32 sz = readBF<u32>(is);
+        doctors.reserve(sz);
+
+        for (u32 i = 0; i < sz; ++i) doctors.push_back(loadUser(is, true));
+
+        sz = readBF<u32>(is);
+        patients.reserve(sz);
+
+        for (u32 i = 0; i < sz; ++i) patients.push_back(loadUser(is, false));
+
+        loadAppointments(is, appointments, false);
+    }
+
+    doctorIndex.Build(doctors, appointments, recurrences);
+    return true;
 }
 
-void Serializer::LoadData(std::vector<User>& doctors, std::vector<User>& patients, std::vector<std::shared_ptr<Appointment>>& appointments) const {
+void Serializer::SaveSnapshot(const std::string& file, const std::vector<User>& doctors, const std::vector<User>& patients, const std::vector<std::shared_ptr<Appointment>>& appointments, const std::vector<std::shared_ptr<Recurrence>>& recurrences) const {
+    ThreadPool& pool = ThreadPool::Shared();
+    std::string doctorsBlock, patientsBlock, appointmentsBlock, recurrencesBlock;
+    std::vector<std::future<void>> tasks;
+
+    tasks.push_back(pool.Submit([&] { doctorsBlock = packBlock(encodeCompactUsers(doctors, true)); }));
+    tasks.push_back(pool.Submit([&] { patientsBlock = packBlock(encodeCompactUsers(patients, false)); }));
+    tasks.push_back(pool.Submit([&] { appointmentsBlock = packBlock(encodeCompactAppointments(appointments)); }));
+    tasks.push_back(pool.Submit([&] { recurrencesBlock = packBlock(encodeCompactRecurrences(recurrences)); }));
+
+    ThreadPool::Wait(tasks);
+
+    std::ofstream os(file, std::ios::binary);
+
+    writeBF<u32>(os, SnapshotMagic);
+    writeBF<u32>(os, SnapshotVersion);
+
+    os.write(doctorsBlock.data(), doctorsBlock.size());
+    os.write(patientsBlock.data(), patientsBlock.size());
+    os.write(appointmentsBlock.data(), appointmentsBlock.size());
+    os.write(recurrencesBlock.data(), recurrencesBlock.size());
+
+    os.close();
+}
+
+bool Serializer::LoadDirectory(std::vector<User>& doctors, std::vector<User>& patients) {
+    const ScopedTimer timer (Timer::LoadDirectory);
+
+    std::ifstream is(SaveFile, std::ios::binary);
+    if (readBF<u32>(is) != Magic) return false;
+
+    const u32 version = readBF<u32>(is);
+    if (version > Version) return false;
+
+    timedRows = version >= TimedVersion;
+
+    listsOffset = readBF<u64>(is);
+    appointmentsOffset = readBF<u64>(is);
+
+    loadDirectory(is, doctors, doctorEntries, true);
+    loadDirectory(is, patients, patientEntries, false);
+
+    is.close();
+    return true;
+}
+
+User Serializer::LoadUser(const bool isDoctor, const u32 idx) const {
+    std::ifstream is(SaveFile, std::ios::binary);
+    is.seekg((isDoctor ? doctorEntries : patientEntries)[idx].record);
+
+    return loadUser(is, isDoctor);
+}
+
+void Serializer::LoadUserAppointments(const bool isDoctor, const u32 idx, std::vector<std::shared_ptr<Appointment>>& appointments, std::vector<u32>& positions) const {
+    const DirectoryEntry& entry = (isDoctor ? doctorEntries : patientEntries)[idx];
     std::ifstream is(SaveFile, std::ios::binary);
 
-    u32 sz = readBF<u32>(is);
-    doctors.reserve(sz);
+    is.seekg(listsOffset + sizeof(u32) + static_cast<u64>(entry.listStart) * sizeof(u32));
+    positions.resize(entry.listCount);
+    for (u32& position : positions) position = readBF<u32>(is);
 
-    for (u32 i = 0; i < sz; ++i) doctors.push_back(loadDoctor(is));
+    const u32 rowSize = timedRows ? AppointmentSize : UntimedAppointmentSize;
+    char row[AppointmentSize];
+    const u64 base = appointments.size();
+    appointments.resize(base + entry.listCount);
 
-    sz = readBF<u32>(is);
-    patients.reserve(sz);
+    for (u32 i = 0; i < entry.listCount; ++i) {
+        is.seekg(appointmentsOffset + sizeof(u32) + static_cast<u64>(positions[i]) * rowSize);
+        is.read(row, rowSize);
+        unpackAppointments(row, timedRows, appointments, base + i, base + i + 1);
+    }
+}
+
+void Serializer::SaveArchive(const u32 year, const std::vector<std::shared_ptr<Appointment>>& appointments) const {
+    std::ofstream os(pendingFile(year), std::ios::binary);
+    saveAppointments(os, appointments);
+    os.close();
+}
+
+void Serializer::CommitArchive(const u32 year) const {
+    fs::rename(pendingFile(year), archiveFile(year));
+}
 
-    for (u32 i = 0; i < sz; ++i) patients.emplace_back(loadPatient(is));
+void Serializer::DiscardArchive(const u32 year) const {
+    fs::remove(pendingFile(year));
+}
+
+void Serializer::LoadArchive(const u32 year, std::vector<std::shared_ptr<Appointment>>& appointments) const {
+    if (!fs::is_regular_file(archiveFile(year))) return;
+
+    std::ifstream is(archiveFile(year), std::ios::binary);
+
+    if (readBF<u32>(is) == ArchiveMagic) {
+        readBF<u32>(is);
+        loadAppointments(is, appointments, true);
+    }
+    else is.seekg(0), loadAppointments(is, appointments, false);
+
+    is.close();
+}
+
+std::vector<u32> Serializer::ArchiveYears() const {
+    return scanYears("");
+}
+
+std::vector<u32> Serializer::PendingArchives() const {
+    return scanYears(".pending");
+}
+
+void Serializer::SaveWaitlist(const Waitlist& waitlist) const {
+    std::vector<WaitlistEntry> pending;
+
+    for (const WaitlistEntry& entry : waitlist.Entries())
+        if (!Waitlist::Settled(entry.status)) pending.push_back(entry);
+
+    std::ofstream os(waitlistFile(), std::ios::binary);
+
+    writeBF<u32>(os, WaitlistMagic);
+    writeBF<u32>(os, WaitlistVersion);
+    writeBF<u32>(os, pending.size());
+
+    std::string data (pending.size() * recordSize<Schema<WaitlistEntry>>(), '\0');
+    char* out = data.data();
+
+    for (const WaitlistEntry& entry : pending) out = packRecord(out, entry);
+    os.write(data.data(), data.size());
+
+    os.close();
+}
+
+void Serializer::LoadWaitlist(Waitlist& waitlist) const {
+    if (!fs::is_regular_file(waitlistFile())) return;
+
+    std::ifstream is(waitlistFile(), std::ios::binary);
+    if (readBF<u32>(is) != WaitlistMagic || readBF<u32>(is) > WaitlistVersion) return;
+
+    const u32 sz = readBF<u32>(is);
+    std::string data (static_cast<u64>(sz) * recordSize<Schema<WaitlistEntry>>(), '\0');
+    is.read(data.data(), data.size());
+
+    const char* in = data.data();
+
+    for (u32 i = 0; i < sz; ++i) {
+        WaitlistEntry entry;
+        in = unpackRecord(in, entry);
+        waitlist.Restore(entry);
+    }
 
-    loadAppointments(is, appointments);
     is.close();
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+
+void ThreadPool::work() {
+    while (true) {
+        std::packaged_task<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+            if (stopping && tasks.empty()) return;
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+    }
+}
+
+ThreadPool::ThreadPool(const u32 threads) {
+    workers.reserve(threads);
+    for (u32 i=0; i < threads; ++i) workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    condition.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+u32 ThreadPool::Size() const {
+    return workers.size();
+}
+
+u32 ThreadPool::ChunkCount(const u64 count, const u64 minChunk) const {
+    return static_cast<u32>(std::clamp<u64>(count / std::max<u64>(minChunk, 1), 1, Size() * 4));
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> fn) {
+    std::packaged_task<void()> task (std::move(fn));
+    std::future<void> result = task.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+
+    condition.notify_one();
+    return result;
+}
+
+std::vector<std::future<void>> ThreadPool::SubmitChunks(const u64 count, const u64 minChunk, const std::function<void(const u32, const u64, const u64)>& fn) {
+    const u32 chunks = ChunkCount(count, minChunk);
+
+    std::vector<std::future<void>> results;
+    results.reserve(chunks);
+
+    for (u32 i=0; i < chunks; ++i)
+        results.push_back(Submit([fn, i, count, chunks] { fn(i, count * i / chunks, count * (i + 1) / chunks); }));
+
+    return results;
+}
+
+void ThreadPool::ParallelFor(const u64 count, const u64 minChunk, const std::function<void(const u32, const u64, const u64)>& fn) {
+    if (ChunkCount(count, minChunk) == 1) return fn(0, 0, count);
+
+    std::vector<std::future<void>> results = SubmitChunks(count, minChunk, fn);
+    Wait(results);
+}
+
+void ThreadPool::Wait(std::vector<std::future<void>>& results) {
+    for (std::future<void>& result : results) result.get();
+}
+
+ThreadPool& ThreadPool::Shared() {
+    const char* threads = std::getenv("CLINIC_THREADS");
+    static ThreadPool pool (std::max(1u, threads ? static_cast<u32>(std::strtoul(threads, nullptr, 10)) : std::thread::hardware_concurrency()));
+    return pool;
+}
\ No newline at end of file
@@ -63,36 +63,14 @@ void clearScreen() {
     #endif
 }
 
-template u8 readBF<u8>(std::ifstream& is);
-template wchar_t readBF<wchar_t>(std::ifstream& is);
-template u32 readBF<u32>(std::ifstream& is);
-template Type readBF<Type>(std::ifstream& is);
-
-template <typename T>
-T readBF(std::ifstream& is) {
-    T n;
-    is.read(reinterpret_cast<char*>(&n), sizeof(T));
-    return n;
-}
-
-template void writeBF<u8>(std::ofstream& is, u8 n);
-template void writeBF<wchar_t>(std::ofstream& is, wchar_t n);
-template void writeBF<u32>(std::ofstream& is, u32 n);
-template void writeBF<Type>(std::ofstream& is, Type n);
-
-template <typename T>
-void writeBF(std::ofstream& os, T n) {
-    os.write(reinterpret_cast<char*>(&n), sizeof(T));
-}
-
-void writeStr(std::ofstream& os, const std::string& str) {
+void writeStr(std::ostream& os, const std::string& str) {
     u32 size = str.size();
 
     writeBF<u32>(os, size);
     for(const char c : str) writeBF<u8>(os, c);
 }
 
-std::string readStr(std::ifstream& is) {
+std::string readStr(std::istream& is) {
     u32 size = readBF<u32>(is);
 
     std::string str (size, ' ');
@@ -100,14 +78,14 @@ std::string readStr(std::ifstream& is) {
     return str;
 }
 
-void writeWstr(std::ofstream& os, const std::wstring& wstr) {
+void writeWstr(std::ostream& os, const std::wstring& wstr) {
     u32 size = wstr.size();
     
     writeBF<u32>(os, size);
     for(const wchar_t wc : wstr) writeBF<wchar_t>(os, wc);
 }
 
-std::wstring readWstr(std::ifstream& is) {
+std::wstring readWstr(std::istream& is) {
     u32 size = readBF<u32>(is);
 
     std::wstring wstr(size, L' ');
@@ -115,6 +93,61 @@ std::wstring readWstr(std::ifstream& is) {
     return wstr;
 }
 
+MemoryBuffer::MemoryBuffer(const char* begin, const char* end) {
+    char* first = const_cast<char*>(begin);
+    setg(first, first, const_cast<char*>(end));
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) {
+    char* base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+    if (base + off < eback() || base + off > egptr()) return pos_type(off_type(-1));
+
+    setg(eback(), base + off, egptr());
+    return gptr() - eback();
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekpos(pos_type pos, std::ios_base::openmode mode) {
+    return seekoff(off_type(pos), std::ios_base::beg, mode);
+}
+
+std::string readFile(const std::string& file) {
+    std::ifstream is(file, std::ios::binary);
+    std::string data (fs::file_size(file), '\0');
+
+    is.read(data.data(), data.size());
+    return data;
+}
+
+void writeVarint(std::ostream& os, u64 n) {
+    while (n >= 0x80) {
+        writeBF<u8>(os, static_cast<u8>(n) | 0x80);
+        n >>= 7;
+    }
+
+    writeBF<u8>(os, static_cast<u8>(n));
+}
+
+u64 readVarint(std::istream& is) {
+    u64 n = 0;
+
+    for (u32 shift = 0; shift < 64; shift += 7) {
+        const u8 byte = readBF<u8>(is);
+        n |= static_cast<u64>(byte & 0x7F) << shift;
+
+        if (!(byte & 0x80) || !is) break;
+    }
+
+    return n;
+}
+
+u64 readCount(std::istream& is) {
+    const u64 n = readVarint(is);
+    if (n <= static_cast<u64>(std::max<std::streamsize>(is.rdbuf()->in_avail(), 0))) return n;
+
+    is.setstate(std::ios::failbit);
+    return 0;
+}
+
 RGB::RGB(u8 r, u8 g, u8 b) : r(r), g(g), b(b) {}
 RGB::RGB(u8 c) : r(c), g(c), b(c) {}
 
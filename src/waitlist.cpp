@@ -0,0 +1,132 @@
+#include "waitlist.h"
+#include <algorithm>
+
+bool Waitlist::before(const u32 a, const u32 b) const {
+    const WaitlistEntry& x = entries[a];
+    const WaitlistEntry& y = entries[b];
+
+    return x.urgency != y.urgency ? x.urgency > y.urgency : x.requested < y.requested;
+}
+
+std::vector<u32>& Waitlist::queue(const WaitlistEntry& entry) {
+    return entry.doctorIdx == AnyDoctor
+        ? specializationQueues[std::make_pair(static_cast<u32>(entry.specialization), entry.date.days())]
+        : doctorQueues[std::make_pair(entry.doctorIdx, entry.date.days())];
+}
+
+void Waitlist::push(const u32 id) {
+    std::vector<u32>& heap = queue(entries[id]);
+
+    heap.push_back(id);
+    std::push_heap(heap.begin(), heap.end(), [this](const u32 a, const u32 b) { return before(b, a); });
+}
+
+void Waitlist::track(const u32 id) {
+    patientIds[entries[id].patientIdx].push_back(id);
+    if (entries[id].status == WaitStatus::Waiting) push(id);
+}
+
+u32 Waitlist::top(std::map<Key, std::vector<u32>>& queues, const Key& key) {
+    const auto it = queues.find(key);
+    if (it == queues.end()) return None;
+
+    std::vector<u32>& heap = it->second;
+
+    while (!heap.empty() && entries[heap.front()].status != WaitStatus::Waiting) {
+        std::pop_heap(heap.begin(), heap.end(), [this](const u32 a, const u32 b) { return before(b, a); });
+        heap.pop_back();
+    }
+
+    if (heap.empty()) {
+        queues.erase(it);
+        return None;
+    }
+
+    return heap.front();
+}
+
+void Waitlist::compact() {
+    if (entries.size() < CompactThreshold || settled * 2 < entries.size()) return;
+
+    std::vector<WaitlistEntry> kept;
+    kept.reserve(entries.size() - settled);
+
+    for (const WaitlistEntry& entry : entries)
+        if (!Settled(entry.status)) kept.push_back(entry);
+
+    entries = std::move(kept);
+    settled = 0;
+    doctorQueues.clear();
+    specializationQueues.clear();
+    patientIds.clear();
+
+    for (u32 i=0; i < entries.size(); ++i) track(i);
+}
+
+void Waitlist::Add(const u32 patientIdx, const u32 doctorIdx, const Type specialization, const Date& date, const u8 urgency) {
+    compact();
+    entries.push_back(WaitlistEntry { patientIdx, doctorIdx, specialization, date, 0, urgency, nextRequest++, WaitStatus::Waiting });
+    track(entries.size() - 1);
+}
+
+void Waitlist::Restore(const WaitlistEntry& entry) {
+    entries.push_back(entry);
+    nextRequest = std::max(nextRequest, entry.requested + 1);
+
+    if (Settled(entry.status)) ++settled;
+    track(entries.size() - 1);
+}
+
+void Waitlist::Withdraw(const u32 id) {
+    if (id >= entries.size() || entries[id].status == WaitStatus::Withdrawn) return;
+
+    if (!Settled(entries[id].status)) ++settled;
+    entries[id].status = WaitStatus::Withdrawn;
+}
+
+void Waitlist::Notify(const u32 id) {
+    if (id >= entries.size() || entries[id].status != WaitStatus::Booked) return;
+
+    ++settled;
+    entries[id].status = WaitStatus::Notified;
+}
+
+u32 Waitlist::Match(const u32 doctorIdx, const Type specialization, const Date& date, const u16 start) {
+    compact();
+
+    const u32 byDoctor = top(doctorQueues, std::make_pair(doctorIdx, date.days()));
+    const u32 bySpecialization = top(specializationQueues, std::make_pair(static_cast<u32>(specialization), date.days()));
+
+    const u32 id = byDoctor == None ? bySpecialization
+                 : bySpecialization == None ? byDoctor
+                 : before(bySpecialization, byDoctor) ? bySpecialization : byDoctor;
+
+    if (id == None) return None;
+
+    WaitlistEntry& entry = entries[id];
+    entry.status = WaitStatus::Booked;
+    entry.doctorIdx = doctorIdx;
+    entry.start = start;
+
+    return id;
+}
+
+bool Waitlist::Settled(const WaitStatus status) {
+    return status == WaitStatus::Withdrawn || status == WaitStatus::Notified;
+}
+
+const std::vector<WaitlistEntry>& Waitlist::Entries() const {
+    return entries;
+}
+
+std::vector<u32> Waitlist::PatientEntries(const u32 patientIdx) const {
+    std::vector<u32> ids;
+
+    const auto it = patientIds.find(patientIdx);
+    if (it == patientIds.end()) return ids;
+
+    for (const u32 id : it->second)
+        if (entries[id].status != WaitStatus::Withdrawn) ids.push_back(id);
+
+    return ids;
+}
\ No newline at end of file